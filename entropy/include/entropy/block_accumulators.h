@@ -0,0 +1,170 @@
+#pragma once
+#include <entropy/byte_histogram.h>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The header contains randomness tests, calculated in the same pass as the byte histogram
+// Set of tests and formulas follows the `ent` utility: http://www.fourmilab.ch/random/
+
+namespace entropy {
+
+/// @brief Named values reported by accumulators, in the order of accumulators
+using accumulator_results = std::vector<std::pair<std::string, double>>;
+
+/// @brief Statistic updated block by block while the byte histogram is counted
+/// Every accumulator covers a contiguous range of the stream starting at some offset,
+/// so that ranges counted by different threads could be merged in order
+class BlockAccumulator {
+public:
+
+    virtual ~BlockAccumulator() = default;
+
+    /// @brief Create empty accumulator of the same type, covering range starting at stream_offset
+    virtual std::unique_ptr<BlockAccumulator> clone_empty(uintmax_t stream_offset) const = 0;
+
+    /// @brief Accept the next block of the range
+    virtual void update(const uint8_t* block, size_t block_size) = 0;
+
+    /// @brief Append the accumulator of the range directly following this one
+    /// @param next: accumulator of the same type
+    virtual void merge(const BlockAccumulator& next) = 0;
+
+    /// @brief Append calculated values, counts are the histogram of the whole range
+    virtual void report(const byte_histogram& counts, accumulator_results& results) const = 0;
+
+    /// @brief Unique accumulator name, identifies the saved state
+    virtual const char* name() const = 0;
+
+    /// @brief Write the state in binary form, so that the pass could be resumed
+    virtual void save(std::ostream& state) const {}
+
+    /// @brief Restore the state written by save()
+    virtual void load(std::istream& state) {}
+};
+
+/// @brief Chi-square distribution of bytes and probability to exceed it for a random sequence
+/// Calculated from the histogram only, so the pass is not affected
+class ChiSquareAccumulator : public BlockAccumulator {
+public:
+    std::unique_ptr<BlockAccumulator> clone_empty(uintmax_t stream_offset) const override;
+    void update(const uint8_t* block, size_t block_size) override {}
+    void merge(const BlockAccumulator& next) override {}
+    void report(const byte_histogram& counts, accumulator_results& results) const override;
+    const char* name() const override { return "chi_square"; }
+};
+
+/// @brief Arithmetic mean of bytes, 127.5 for a random sequence
+/// Calculated from the histogram only, so the pass is not affected
+class ArithmeticMeanAccumulator : public BlockAccumulator {
+public:
+    std::unique_ptr<BlockAccumulator> clone_empty(uintmax_t stream_offset) const override;
+    void update(const uint8_t* block, size_t block_size) override {}
+    void merge(const BlockAccumulator& next) override {}
+    void report(const byte_histogram& counts, accumulator_results& results) const override;
+    const char* name() const override { return "arithmetic_mean"; }
+};
+
+/// @brief Monte Carlo value for Pi, every 6 bytes are 24-bit (x, y) coordinates in a square
+/// Groups are aligned to the stream start, not to the range start
+class MonteCarloPiAccumulator : public BlockAccumulator {
+public:
+
+    explicit MonteCarloPiAccumulator(uintmax_t stream_offset = 0);
+
+    std::unique_ptr<BlockAccumulator> clone_empty(uintmax_t stream_offset) const override;
+    void update(const uint8_t* block, size_t block_size) override;
+    void merge(const BlockAccumulator& next) override;
+    void report(const byte_histogram& counts, accumulator_results& results) const override;
+    const char* name() const override { return "monte_carlo_pi"; }
+    void save(std::ostream& state) const override;
+    void load(std::istream& state) override;
+
+    static constexpr size_t GROUP_SIZE = 6;
+
+private:
+
+    /// Count one (x, y) point
+    void add_point(const uint8_t* group);
+
+    /// Bytes before the first aligned group, belong to the group of the previous range
+    uint8_t head_[GROUP_SIZE]{};
+    size_t head_size_{};
+    size_t head_needed_{};
+
+    /// Bytes of the incomplete last group
+    uint8_t pending_[GROUP_SIZE]{};
+    size_t pending_size_{};
+
+    uintmax_t points_{};
+    uintmax_t points_in_circle_{};
+};
+
+/// @brief Serial correlation coefficient of adjacent bytes, close to 0.0 for a random sequence
+/// Last byte is correlated with the first one, as `ent` does
+class SerialCorrelationAccumulator : public BlockAccumulator {
+public:
+    std::unique_ptr<BlockAccumulator> clone_empty(uintmax_t stream_offset) const override;
+    void update(const uint8_t* block, size_t block_size) override;
+    void merge(const BlockAccumulator& next) override;
+    void report(const byte_histogram& counts, accumulator_results& results) const override;
+    const char* name() const override { return "serial_correlation"; }
+    void save(std::ostream& state) const override;
+    void load(std::istream& state) override;
+
+private:
+    bool has_data_{};
+    uint8_t first_{};
+    uint8_t last_{};
+
+    /// Sum of products of adjacent bytes inside the range
+    uintmax_t adjacent_products_{};
+};
+
+/// @brief Pluggable set of accumulators, updated in the same pass as the histogram
+/// Empty set costs one branch per block
+class AccumulatorSet {
+public:
+
+    AccumulatorSet() = default;
+    AccumulatorSet(AccumulatorSet&&) = default;
+    AccumulatorSet& operator=(AccumulatorSet&&) = default;
+    AccumulatorSet(const AccumulatorSet&) = delete;
+    AccumulatorSet& operator=(const AccumulatorSet&) = delete;
+
+    /// @brief Register accumulator, results are reported in order of registration
+    void add(std::unique_ptr<BlockAccumulator> accumulator);
+
+    bool empty() const {
+        return accumulators_.empty();
+    }
+
+    /// @brief Create empty set of the same accumulators for the range starting at stream_offset
+    AccumulatorSet clone_empty(uintmax_t stream_offset) const;
+
+    /// @brief Accept the next block of the range
+    void update(const uint8_t* block, size_t block_size);
+
+    /// @brief Append the set of the range directly following this one
+    void merge(const AccumulatorSet& next);
+
+    /// @brief Calculate values of all accumulators, counts are the histogram of the whole range
+    accumulator_results report(const byte_histogram& counts) const;
+
+    /// @brief Write names and states of all accumulators
+    void save(std::ostream& state) const;
+
+    /// @brief Restore states written by save()
+    /// @return false if the state was written by a different set of accumulators
+    bool load(std::istream& state);
+
+    /// @brief Set with all randomness tests reported by `ent`
+    static AccumulatorSet randomness_battery();
+
+private:
+    std::vector<std::unique_ptr<BlockAccumulator>> accumulators_;
+};
+
+} // namespace entropy
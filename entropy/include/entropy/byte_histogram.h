@@ -0,0 +1,26 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace entropy {
+
+/// @brief Count of every byte value 0x00..0xFF met in a sequence
+/// Histograms of adjacent (or unrelated) ranges are simply added together
+using byte_histogram = std::array<uintmax_t, 256>;
+
+/// @brief Add byte counts of the block to the histogram
+void count_bytes(const uint8_t* block, size_t block_size, byte_histogram& counts);
+
+/// @brief Add all counts of the other histogram
+void merge_histograms(byte_histogram& counts, const byte_histogram& other);
+
+/// @brief Total number of bytes counted in the histogram
+uintmax_t histogram_total(const byte_histogram& counts);
+
+/// @brief Convert counts to probabilities to meet some byte
+/// Zero-sized histogram gives all-zero probabilities
+std::vector<double> histogram_probabilities(const byte_histogram& counts);
+
+} // namespace entropy
@@ -0,0 +1,129 @@
+#pragma once
+#include <entropy/byte_histogram.h>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// The header contains content-defined chunking (FastCDC with Gear rolling hash)
+// with per-chunk entropy and recognition of repeated chunks
+// Algorithm: https://www.usenix.org/conference/atc16/technical-sessions/presentation/xia
+
+namespace entropy {
+
+/// @brief Chunk size limits, boundaries are searched between min and max size
+struct ChunkingOptions {
+    size_t min_size = 2 * 1024;
+    size_t average_size = 8 * 1024;
+    size_t max_size = 64 * 1024;
+
+    /// Histograms of unique chunks kept for reuse, 1 KB each
+    size_t max_cached_histograms = 64 * 1024;
+
+    /// Unique chunks indexed to recognise repeats, about 64 bytes each (256 MB by default, 32 GB of unique data at 8 KB chunks)
+    /// Chunks past the limit are not indexed, their repeats are counted as unique
+    size_t max_indexed_chunks = 4 * 1024 * 1024;
+
+    /// @brief Limits derived from the average size as FastCDC suggests: min = avg / 4, max = avg * 8
+    static ChunkingOptions from_average(size_t average_size);
+};
+
+/// @brief Single chunk of the stream
+struct ChunkRecord {
+    uintmax_t offset{};
+    size_t size{};
+    uint64_t hash{};
+    double entropy{};
+
+    /// Same chunk (by hash and size) was met before
+    bool duplicate{};
+};
+
+/// @brief Totals of the chunked stream
+struct ChunkingSummary {
+    uintmax_t total_bytes{};
+    uintmax_t unique_bytes{};
+    uintmax_t chunks_count{};
+    uintmax_t unique_chunks_count{};
+
+    /// Unique chunks not indexed because the index was full
+    uintmax_t unindexed_chunks_count{};
+
+    /// Histogram of the whole stream, sum of chunk histograms
+    byte_histogram counts{};
+
+    /// @brief Repeats of unindexed chunks were missed, dedup ratio is a lower bound
+    bool dedup_estimated() const {
+        return unindexed_chunks_count != 0;
+    }
+
+    /// @brief Total size to the size of unique chunks, 1.0 if there are no duplicates
+    double dedup_ratio() const {
+        return unique_bytes ? static_cast<double>(total_bytes) / unique_bytes : 1.;
+    }
+};
+
+/// @brief Split the stream into content-defined chunks block by block
+/// Repeated chunks are recognised by 64-bit hash and size, their cached histograms
+/// are reused instead of counting the bytes again
+/// Memory is bounded: both the index of unique chunks and the histograms cache have limits
+class ContentChunker {
+public:
+
+    using chunk_callback_t = std::function<void(const ChunkRecord&)>;
+
+    /// @param on_chunk: called for every chunk in stream order, could be empty
+    ContentChunker(const ChunkingOptions& options, chunk_callback_t on_chunk);
+
+    /// @brief Accept the next block of the stream
+    void update(const uint8_t* block, size_t block_size);
+
+    /// @brief Emit the last incomplete chunk, must be called at the end of stream
+    void finish();
+
+    const ChunkingSummary& summary() const {
+        return summary_;
+    }
+
+private:
+
+    /// Histogram of the chunk, chunk size is always less than 4 GB
+    using chunk_histogram = std::array<uint32_t, 256>;
+
+    /// Unique chunk met before
+    struct CachedChunk {
+        size_t size{};
+        double entropy{};
+
+        /// Index in cached_histograms_, or NOT_CACHED
+        size_t histogram_index{};
+    };
+
+    /// Scan for the chunk boundary
+    /// @return number of bytes belonging to the current chunk, boundary_found_ is set if it ends there
+    size_t find_boundary(const uint8_t* data, size_t data_size);
+
+    /// Hash, count and report the current chunk
+    void emit_chunk();
+
+    static constexpr size_t NOT_CACHED = static_cast<size_t>(-1);
+
+    ChunkingOptions options_;
+    chunk_callback_t on_chunk_;
+
+    /// Gear masks: harder one before the average size, easier one after it (normalized chunking)
+    uint64_t mask_small_{};
+    uint64_t mask_large_{};
+
+    /// Current chunk state
+    std::vector<uint8_t> chunk_;
+    uint64_t fingerprint_{};
+    bool boundary_found_{};
+
+    std::unordered_map<uint64_t, CachedChunk> chunks_;
+    std::vector<chunk_histogram> cached_histograms_;
+    ChunkingSummary summary_;
+};
+
+} // namespace entropy
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// The header contains zero-copy parser of ELF executable headers
+// Image is never copied: section names and ranges refer to the caller's buffer (usually a file mapping)
+// Format: https://refspecs.linuxfoundation.org/elf/gabi4+/contents.html
+
+namespace entropy {
+
+/// @brief File range of the section or the segment
+struct ElfRegion {
+
+    enum Kind {
+        Section,
+        Segment
+    };
+
+    Kind kind = Section;
+
+    /// Section name from the section names table or segment type name, e.g. ".text" or "LOAD"
+    /// Points to the image or to a static string, never null
+    const char* name = "";
+
+    /// sh_type or p_type
+    uint32_t type{};
+
+    /// sh_flags or p_flags
+    uint64_t flags{};
+
+    /// Range in the file, clipped by the file end for malformed headers
+    uint64_t offset{};
+    uint64_t size{};
+
+    /// Header declares more bytes than the file contains
+    bool truncated{};
+};
+
+/// @brief Sections and segments of the ELF image (32/64-bit, both byte orders)
+/// Image buffer must outlive the parser and its regions
+class ElfImage {
+public:
+
+    /// @brief Parse headers of the image
+    /// @throw std::runtime_error if ELF header or header tables are malformed
+    ElfImage(const uint8_t* image, size_t image_size);
+
+    /// @brief Whether the buffer starts with ELF magic
+    static bool is_elf(const uint8_t* image, size_t image_size);
+
+    /// @brief Sections present in the file, SHT_NOBITS sections have zero size
+    const std::vector<ElfRegion>& sections() const {
+        return sections_;
+    }
+
+    /// @brief Segments of the program headers table
+    const std::vector<ElfRegion>& segments() const {
+        return segments_;
+    }
+
+    bool is_64bit() const {
+        return is_64bit_;
+    }
+
+    bool is_little_endian() const {
+        return is_little_endian_;
+    }
+
+    /// e_machine, e.g. 62 for x86-64
+    uint16_t machine() const {
+        return machine_;
+    }
+
+    /// @brief Flags as readelf shows them: "WAX" for sections, "RWE" for segments
+    static std::string flags_description(const ElfRegion& region);
+
+private:
+
+    /// Read unsigned field of the image in its byte order, offset should be checked before
+    template <typename T>
+    T read(uint64_t offset) const;
+
+    /// Read the field of 64-bit or 32-bit size depending on ELF class
+    uint64_t read_word(uint64_t offset) const;
+
+    /// Min size of the section header for the ELF class
+    uint64_t section_header_size() const;
+
+    /// Check that the table fits the image
+    void check_table(uint64_t offset, uint64_t entries_count, uint64_t entry_size, 
+        uint64_t min_entry_size, const char* table) const;
+
+    /// Region range clipped by the image end
+    void set_range(ElfRegion& region, uint64_t offset, uint64_t size) const;
+
+    void read_sections(uint64_t table_offset, uint64_t entries_count, uint64_t entry_size, uint32_t names_index);
+    void read_segments(uint64_t table_offset, uint64_t entries_count, uint64_t entry_size);
+
+    /// Name from the section names table, empty if the table is corrupted
+    const char* section_name(uint64_t names_offset, uint64_t names_size, uint32_t name_offset) const;
+
+    /// Readable name of the segment type
+    static const char* segment_name(uint32_t type);
+
+    const uint8_t* image_;
+    size_t image_size_;
+
+    bool is_64bit_{};
+    bool is_little_endian_{};
+    uint16_t machine_{};
+
+    std::vector<ElfRegion> sections_;
+    std::vector<ElfRegion> segments_;
+};
+
+} // namespace entropy
@@ -0,0 +1,83 @@
+#pragma once
+#include <entropy/byte_histogram.h>
+#include <entropy/quantile_sketch.h>
+#include <map>
+#include <string>
+
+// The header contains aggregation of per-file results of the batch scan
+// Aggregators are mergeable: every scanning thread fills its own shard,
+// shards are folded into the final report at the end
+
+namespace entropy {
+
+/// @brief Aggregated results of the group of files
+struct GroupStatistics {
+
+    uintmax_t files_count{};
+
+    /// Summed byte histograms, entropy of the group as a single stream
+    byte_histogram counts{};
+
+    /// Distribution of per-file entropy
+    QuantileSketch entropy;
+
+    void add(double file_entropy, const byte_histogram& file_counts);
+    void merge(const GroupStatistics& other);
+};
+
+/// @brief Per-extension, per-directory subtree and per-size class statistics of scanned files
+/// Number of groups of every kind is limited, files of the rest groups fall into OTHER_GROUP
+class EntropyAggregator {
+public:
+
+    using groups_t = std::map<std::string, GroupStatistics>;
+
+    /// @param directory_depth: subtrees up to this depth below the scan root are aggregated
+    /// @param max_groups: max number of groups of every kind
+    explicit EntropyAggregator(size_t directory_depth = 1, size_t max_groups = 1024);
+
+    /// @brief Account the scanned file
+    /// @param relative_path: path relative to the scan root, '/' separated
+    void add(const std::string& relative_path, double file_entropy, const byte_histogram& file_counts);
+
+    /// @brief Fold the other shard into this one
+    void merge(const EntropyAggregator& other);
+
+    /// @brief All files
+    const GroupStatistics& total() const {
+        return total_;
+    }
+
+    const groups_t& extensions() const {
+        return extensions_;
+    }
+
+    const groups_t& directories() const {
+        return directories_;
+    }
+
+    const groups_t& size_classes() const {
+        return size_classes_;
+    }
+
+    /// @brief Size class of the file: power of two range in bytes, e.g. "12: 4K-8K"
+    static std::string size_class(uintmax_t file_size);
+
+    /// Group of files over the groups limit
+    static const char* const OTHER_GROUP;
+
+private:
+
+    /// Find or create the group, respecting the limit
+    GroupStatistics& group(groups_t& groups, const std::string& key);
+
+    size_t directory_depth_;
+    size_t max_groups_;
+
+    GroupStatistics total_;
+    groups_t extensions_;
+    groups_t directories_;
+    groups_t size_classes_;
+};
+
+} // namespace entropy
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// The header contains NUMA nodes discovery and pinning of threads to nodes
+// Nodes are read from sysfs on Linux; elsewhere, or if sysfs is not available,
+// the machine is one node and pinning does nothing
+
+namespace entropy {
+
+/// @brief CPUs of every NUMA node having CPUs
+class NumaTopology {
+public:
+
+    /// @brief Single node, pinning does nothing
+    NumaTopology() = default;
+
+    /// @brief Read nodes of the machine
+    static NumaTopology detect();
+
+    size_t nodes_count() const {
+        return nodes_.empty() ? 1 : nodes_.size();
+    }
+
+    /// @brief Node of the worker when workers_count workers are spread over nodes in contiguous groups
+    size_t worker_node(size_t worker_index, size_t workers_count) const;
+
+    /// @brief Restrict the calling thread to CPUs of the node, so that its allocations stay node-local
+    /// @return false if pinning is not supported or failed
+    bool pin_current_thread(size_t node) const;
+
+private:
+
+    /// CPU numbers per node, empty for the single node machine
+    std::vector<std::vector<int>> nodes_;
+};
+
+} // namespace entropy
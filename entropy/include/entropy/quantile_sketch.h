@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace entropy {
+
+/// @brief KLL quantile sketch: bounded memory, mergeable, rank error about 1.7 / k
+/// Paper: https://arxiv.org/abs/1603.05346
+/// Compaction coin is a deterministic generator, so the same input gives the same sketch
+class QuantileSketch {
+public:
+
+    /// @param k: accuracy parameter, memory is about 3 * k values
+    explicit QuantileSketch(size_t k = 200);
+
+    void add(double value);
+
+    /// @brief Add all values of the other sketch
+    void merge(const QuantileSketch& other);
+
+    /// @brief Approximate value of the quantile
+    /// @param quantile: value in range [0, 1]
+    /// @return 0.0 for empty sketch
+    double quantile(double quantile) const;
+
+    uintmax_t count() const {
+        return count_;
+    }
+
+    double min() const {
+        return min_;
+    }
+
+    double max() const {
+        return max_;
+    }
+
+    double mean() const {
+        return count_ ? sum_ / count_ : 0.;
+    }
+
+private:
+
+    /// Number of values the level could hold before compaction
+    size_t capacity(size_t level) const;
+
+    /// Add the next level
+    void grow();
+
+    /// Compact full levels until the sketch fits its max size
+    void compress();
+
+    /// Sort the level and promote every other value to the next one
+    void compact(size_t level);
+
+    /// Total number of stored values
+    size_t stored() const;
+
+    size_t k_;
+    size_t max_stored_{};
+
+    /// Values of the level h have weight 2^h
+    std::vector<std::vector<double>> levels_;
+
+    uintmax_t count_{};
+    double sum_{};
+    double min_{};
+    double max_{};
+    uint64_t coin_state_{ 0x2545F4914F6CDD1DULL };
+};
+
+} // namespace entropy
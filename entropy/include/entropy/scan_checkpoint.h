@@ -0,0 +1,74 @@
+#pragma once
+#include <entropy/byte_histogram.h>
+#include <cstdint>
+#include <string>
+
+namespace entropy {
+
+/// @brief State of the file pass, saved periodically to the small sidecar file
+/// Histogram is additive, so the pass could continue from the saved offset
+/// and produce exactly the same result
+struct ScanCheckpoint {
+
+    /// Size and modification time of the scanned file, changed file is scanned from the start
+    uintmax_t file_size{};
+    int64_t last_write_time{};
+
+    /// Bytes counted so far
+    uintmax_t offset{};
+    byte_histogram counts{};
+
+    /// Binary state of accumulators, see AccumulatorSet::save()
+    std::string accumulators_state;
+
+    /// @brief Write checkpoint atomically, so that crash leaves the previous one intact
+    /// @throw std::runtime_error if checkpoint could not be written, the temporary file is removed
+    void save(const std::string& checkpoint_path) const;
+
+    /// @brief Read checkpoint
+    /// @return false if there is no checkpoint or it is damaged
+    bool load(const std::string& checkpoint_path);
+
+    /// @brief Sidecar file path for the scanned file
+    static std::string sidecar_path(const std::string& file_path);
+};
+
+/// @brief Result of the completed pass over the append-only file (log, journal), kept in the sidecar file
+/// Rescan checks that the last counted block is unchanged and counts only the appended tail
+struct IncrementalState {
+
+    /// Bytes counted, the file is expected to grow past this size
+    uintmax_t file_size{};
+
+    /// Hash of the last block before file_size, rewritten or rotated file does not match it
+    uint64_t tail_size{};
+    uint64_t tail_hash{};
+
+    byte_histogram counts{};
+
+    /// Binary state of accumulators, see AccumulatorSet::save()
+    std::string accumulators_state;
+
+    /// @brief Write state atomically
+    /// @throw std::runtime_error if state could not be written
+    void save(const std::string& state_path) const;
+
+    /// @brief Read state
+    /// @return false if there is no state or it is damaged
+    bool load(const std::string& state_path);
+
+    /// @brief Sidecar file path for the scanned file
+    static std::string sidecar_path(const std::string& file_path);
+
+    /// @brief Hash of the tail block (FNV-1a)
+    static uint64_t block_hash(const uint8_t* block, size_t block_size);
+
+    /// Max hashed tail block, state with the bigger one is rejected as forged or damaged
+    static constexpr uint64_t MAX_TAIL_SIZE = 1024 * 64;
+};
+
+/// @brief Whether the file is a checkpoint or incremental state sidecar (or its temporary file),
+/// so that batch scans skip files written by previous scans
+bool is_scan_sidecar(const std::string& file_path);
+
+} // namespace entropy
@@ -1,9 +1,15 @@
 #pragma once
+#include <entropy/byte_histogram.h>
+#include <entropy/block_accumulators.h>
+#include <entropy/content_chunker.h>
+#include <atomic>
+#include <functional>
 #include <algorithm>
 #include <vector>
 #include <string>
 #include <map>
 #include <cmath>
+#include <cassert>
 
 
 namespace entropy {
@@ -59,6 +65,40 @@ double shannon_entropy(T first, T last, CallbackObj& callback)
     return -entropy;
 }
 
+/// @brief Shannon entropy of the byte histogram, same value as for its probabilities
+/// No allocations, suitable for many small histograms
+double histogram_entropy(const byte_histogram& counts);
+
+/// @brief Rényi entropy of the byte histogram: log2(sum(p^order)) / (1 - order), bits per byte
+/// Order 0 is Hartley (max-) entropy, 1 is Shannon, 2 is collision entropy, infinity is min-entropy
+/// For every histogram value does not grow with the order
+double renyi_entropy(const byte_histogram& counts, double order);
+
+/// @brief Min-entropy: -log2 of the most frequent byte probability, the worst-case guessing bound
+double min_entropy(const byte_histogram& counts);
+
+/// @brief Collision entropy: -log2 of the probability that two random bytes are equal
+double collision_entropy(const byte_histogram& counts);
+
+/// @brief Member of the Rényi entropy family, calculated from the already counted histogram
+struct EntropyMeasure {
+
+    /// Name in reports, e.g. "min_entropy"
+    std::string name;
+
+    /// Rényi order
+    double order{};
+
+    /// @brief Parse "shannon", "min", "collision", "hartley" or "renyi:<order>"
+    /// @throw std::invalid_argument for unknown measure or negative order
+    static EntropyMeasure parse(const std::string& measure);
+
+    /// @brief Parse comma-separated list of measures
+    static std::vector<EntropyMeasure> parse_list(const std::string& measures);
+};
+
+/// @brief Calculate every measure of the set from the same histogram, no data pass is needed
+accumulator_results entropy_measures(const byte_histogram& counts, const std::vector<EntropyMeasure>& measures);
 
 /// @brief Detect whether some sequence (byte, block, memory, disk) is encrypted or highly compressed
 class ShannonEncryptionChecker {
@@ -75,6 +115,9 @@ public:
     /// @brief Callback type for calling on all iterations
     using callback_t = void(*)(uintmax_t);
 
+    /// @brief Callback type for reporting the sidecar file that could not be written
+    using sidecar_error_callback_t = void(*)(const std::string&);
+
     /// @brief Set facet for unsigned char (boost binary reading twice)
     ShannonEncryptionChecker();
 
@@ -83,12 +126,53 @@ public:
     /// @param epsilon: estimated difference between absolute chaos (8.0) and actual entropy
     double get_file_entropy(const std::string& file_path) const;
 
+    /// @brief Calculate file entropy, updating accumulators in the same pass
+    /// @param accumulators: empty set for the stream start, filled with the whole file range
+    /// @param counts: byte histogram of the file, required to report accumulators
+    /// @param restored_bytes: if set, bytes taken from the checkpoint or incremental state instead of reading
+    double get_file_entropy(const std::string& file_path, AccumulatorSet& accumulators, byte_histogram& counts,
+        uintmax_t* restored_bytes = nullptr) const;
+
+    /// @brief Calculate entropy of the file start only, quick check of big files
+    /// @param head_size: max bytes counted from the file start
+    /// @param counts: byte histogram of the counted bytes
+    double get_file_head_entropy(const std::string& file_path, uintmax_t head_size, byte_histogram& counts) const;
+
+    /// @brief Split the file into content-defined chunks, reporting entropy of every chunk
+    /// Chunking, accumulators and the whole file histogram take the same single pass
+    /// @param chunker: receives file blocks, chunker.summary() has the totals after the call
+    /// @return entropy of the whole file
+    double get_file_chunks_entropy(const std::string& file_path, ContentChunker& chunker, AccumulatorSet& accumulators) const;
+
     /// @brief Detect whether the bytes sequence (e.g. memory) is encrypted
     double get_sequence_entropy(const uint8_t* sequence_start, size_t sequence_size) const;
+
+    /// @brief Calculate the bytes sequence entropy, updating accumulators in the same pass
+    double get_sequence_entropy(const uint8_t* sequence_start, size_t sequence_size, 
+        AccumulatorSet& accumulators, byte_histogram& counts) const;
     
     /// @brief Set callback function, accepting value of the bytes counter
     void set_callback(callback_t callback);
 
+    /// @brief Save the file pass state to the sidecar file every checkpoint_interval bytes and on interrupt
+    /// Sidecar file is removed when the pass completes
+    /// @param checkpoint_interval: bytes between checkpoints, 0 disables checkpointing
+    /// @param resume: continue from the sidecar file, if it matches the file
+    void set_checkpoint(uintmax_t checkpoint_interval, bool resume);
+
+    /// @brief Keep the result of the file pass in the sidecar file and count only the appended tail next time
+    /// For append-only files (logs, journals): if the last counted block is unchanged, 
+    /// the rescan reads only bytes written after the previous pass
+    void set_incremental(bool incremental);
+
+    /// @brief Set callback reporting checkpoint or incremental state that could not be written
+    /// Failed sidecar write is not fatal: the pass continues and its result is returned
+    void set_sidecar_error_callback(sidecar_error_callback_t callback);
+
+    /// @brief Stop passes of this checker when the flag is set, in addition to the global interrupt
+    /// Lets the owner cancel its own work without interrupting other scans of the process
+    void set_stop_flag(const std::atomic<bool>* stop_flag);
+
     /// @brief Get information encryption level using provided entropy and sequence size
     InformationEntropyEstimation information_entropy_estimation(double entropy, size_t sequence_size) const;
 
@@ -98,24 +182,62 @@ public:
     /// @brief Provide readable properties of the information sequence
     std::string get_information_description(InformationEntropyEstimation ent) const;
 
-    /// @brief Interrupt all calculating threads
+    /// @brief Interrupt all calculating threads, async-signal-safe
     static void interrupt();
 
+    /// @brief Whether calculations were interrupted, their results are meaningless
+    static bool is_interrupted();
+
 
 private:
 
-    /// do not make it atomic so that avoid cache ping-pong
-    static bool interrupt_all_;
+    /// Set from signal handlers and read by worker threads; relaxed load is a plain load on x86
+    static std::atomic<bool> interrupt_all_;
 
     /// Callback function called on every iteration
     callback_t callback_{};
 
+    /// Called with the error description if the sidecar file could not be written
+    sidecar_error_callback_t sidecar_error_callback_{};
+
+    /// Owner's stop flag, could be null
+    const std::atomic<bool>* stop_flag_{};
+
+    /// Global interrupt or the owner's stop flag is set
+    bool is_stopped() const;
+
+    /// Bytes between checkpoints of the file pass, 0 if disabled
+    uintmax_t checkpoint_interval_{};
+
+    /// Continue the file pass from the checkpoint
+    bool resume_{};
+
+    /// Count only the tail appended since the previous file pass
+    bool incremental_{};
+
     /// Calculate probabilities to meet some byte in the file
     std::vector<double> read_file_probabilities(const std::string& file_path, size_t file_size) const;
 
     /// Calculate probabilities to meet some byte in the sequence
     std::vector<double> read_stream_probabilities(const uint8_t* sequence_start, size_t sequence_size) const;
 
+    /// Count bytes of the file block by block, feeding accumulators if any
+    /// Checkpoints and incremental state are saved and restored here if enabled
+    /// @return false if interrupted
+    bool read_file_counts(const std::string& file_path, byte_histogram& counts, AccumulatorSet* accumulators,
+        uintmax_t* restored_bytes = nullptr) const;
+
+    /// Read the file block by block, checking for interrupt and reporting progress
+    /// @param max_size: bytes to read from the file start
+    /// @return false if interrupted
+    bool read_file_blocks(const std::string& file_path, const std::function<void(const uint8_t*, size_t)>& consume,
+        uintmax_t max_size = UINTMAX_MAX) const;
+
+    /// Count bytes of the sequence block by block, feeding accumulators if any
+    /// @return false if interrupted
+    bool read_stream_counts(const uint8_t* sequence_start, size_t sequence_size, 
+        byte_histogram& counts, AccumulatorSet* accumulators) const;
+
     /// Relate epsilon to checked file size
     /// Entropy of encrypted file very close to 8.0 (like 7.999998..)
     /// However estimation depends on the sample size
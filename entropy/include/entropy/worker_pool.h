@@ -0,0 +1,87 @@
+#pragma once
+#include <entropy/numa_topology.h>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace entropy {
+
+/// @brief Fixed set of worker threads with the bounded tasks queue
+/// Queue limit is the admission control: try_submit() refuses the task instead of growing the queue
+class WorkerPool {
+public:
+
+    using task_t = std::function<void()>;
+
+    /// @param workers_count: number of threads, 0 means hardware concurrency
+    /// @param queue_limit: max number of tasks waiting for a free worker
+    /// @param topology: workers are spread over its nodes in contiguous groups and pinned to them
+    WorkerPool(size_t workers_count, size_t queue_limit, const NumaTopology& topology = NumaTopology());
+
+    /// @brief Complete all queued tasks and join workers
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /// @brief Queue the task if there is a room for it
+    /// @return false if the queue is full or pool is stopped
+    bool try_submit(task_t task);
+
+    /// @brief Queue the task, waiting while the queue is full (backpressure)
+    /// @return false if pool is stopped
+    bool submit(task_t task);
+
+    /// @brief Stop accepting tasks, complete queued ones and join workers
+    void shutdown();
+
+    size_t workers_count() const {
+        return workers_.size();
+    }
+
+    size_t queue_limit() const {
+        return queue_limit_;
+    }
+
+    /// @brief Number of tasks waiting for a free worker
+    size_t queued() const;
+
+    /// @brief NUMA node the worker is pinned to, 0 without topology
+    size_t worker_node(size_t worker_index) const {
+        return topology_.worker_node(worker_index, workers_count_);
+    }
+
+    const NumaTopology& topology() const {
+        return topology_;
+    }
+
+    /// @brief Index of the worker running the current task in range [0, workers_count)
+    /// Tasks use it to pick per-thread shards of results without locking
+    /// @return NOT_WORKER if called outside of pool threads
+    static size_t worker_index();
+
+    static constexpr size_t NOT_WORKER = static_cast<size_t>(-1);
+
+private:
+
+    /// Worker thread loop
+    void work(size_t index);
+
+    NumaTopology topology_;
+    size_t workers_count_{};
+
+    std::vector<std::thread> workers_;
+    std::deque<task_t> tasks_;
+    size_t queue_limit_{};
+    bool stopped_{};
+
+    mutable std::mutex mutex_;
+    std::condition_variable task_ready_;
+    std::condition_variable room_ready_;
+};
+
+} // namespace entropy
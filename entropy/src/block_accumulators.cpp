@@ -0,0 +1,354 @@
+#include <entropy/block_accumulators.h>
+#include <boost/math/special_functions/gamma.hpp>
+#include <boost/math/constants/constants.hpp>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+using namespace entropy;
+
+namespace {
+
+/// Binary state fields, native byte order: state is resumed on the same host
+template <typename T>
+void write_field(std::ostream& state, const T& value)
+{
+    state.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+void read_field(std::istream& state, T& value)
+{
+    state.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+} // namespace
+
+//
+// ChiSquareAccumulator
+//
+
+std::unique_ptr<BlockAccumulator> ChiSquareAccumulator::clone_empty(uintmax_t stream_offset) const
+{
+    return std::make_unique<ChiSquareAccumulator>();
+}
+
+void ChiSquareAccumulator::report(const byte_histogram& counts, accumulator_results& results) const
+{
+    uintmax_t total = histogram_total(counts);
+    if (0 == total) {
+        results.emplace_back("chi_square", 0.);
+        results.emplace_back("chi_square_probability", 0.);
+        return;
+    }
+
+    double expected = static_cast<double>(total) / 256;
+    double chi_square{};
+    for (uintmax_t count : counts) {
+        double diff = static_cast<double>(count) - expected;
+        chi_square += diff * diff / expected;
+    }
+
+    // 255 degrees of freedom, probability in percents as `ent` reports it
+    double probability = boost::math::gamma_q(255. / 2, chi_square / 2) * 100.;
+    results.emplace_back("chi_square", chi_square);
+    results.emplace_back("chi_square_probability", probability);
+}
+
+//
+// ArithmeticMeanAccumulator
+//
+
+std::unique_ptr<BlockAccumulator> ArithmeticMeanAccumulator::clone_empty(uintmax_t stream_offset) const
+{
+    return std::make_unique<ArithmeticMeanAccumulator>();
+}
+
+void ArithmeticMeanAccumulator::report(const byte_histogram& counts, accumulator_results& results) const
+{
+    uintmax_t total = histogram_total(counts);
+    uintmax_t sum{};
+    for (size_t i = 0; i != 256; ++i) {
+        sum += i * counts[i];
+    }
+    results.emplace_back("arithmetic_mean", total ? static_cast<double>(sum) / total : 0.);
+}
+
+//
+// MonteCarloPiAccumulator
+//
+
+MonteCarloPiAccumulator::MonteCarloPiAccumulator(uintmax_t stream_offset)
+    : head_needed_((GROUP_SIZE - stream_offset % GROUP_SIZE) % GROUP_SIZE)
+{
+}
+
+std::unique_ptr<BlockAccumulator> MonteCarloPiAccumulator::clone_empty(uintmax_t stream_offset) const
+{
+    return std::make_unique<MonteCarloPiAccumulator>(stream_offset);
+}
+
+void MonteCarloPiAccumulator::add_point(const uint8_t* group)
+{
+    // Radius of the circle inscribed in the 24-bit square
+    constexpr uint64_t RADIUS = (1 << 24) - 1;
+    constexpr uint64_t RADIUS_SQUARE = RADIUS * RADIUS;
+
+    uint64_t x = (uint64_t{ group[0] } << 16) | (uint64_t{ group[1] } << 8) | group[2];
+    uint64_t y = (uint64_t{ group[3] } << 16) | (uint64_t{ group[4] } << 8) | group[5];
+
+    ++points_;
+    if (x * x + y * y <= RADIUS_SQUARE) {
+        ++points_in_circle_;
+    }
+}
+
+void MonteCarloPiAccumulator::update(const uint8_t* block, size_t block_size)
+{
+    size_t i = 0;
+    while (head_size_ < head_needed_ && i < block_size) {
+        head_[head_size_++] = block[i++];
+    }
+
+    while (i < block_size) {
+        if (0 == pending_size_ && block_size - i >= GROUP_SIZE) {
+            add_point(block + i);
+            i += GROUP_SIZE;
+            continue;
+        }
+
+        pending_[pending_size_++] = block[i++];
+        if (GROUP_SIZE == pending_size_) {
+            add_point(pending_);
+            pending_size_ = 0;
+        }
+    }
+}
+
+void MonteCarloPiAccumulator::merge(const BlockAccumulator& next)
+{
+    const auto& other = static_cast<const MonteCarloPiAccumulator&>(next);
+
+    // head of the next range completes our last group
+    update(other.head_, other.head_size_);
+    if (other.head_size_ < other.head_needed_) {
+        // the next range is shorter than its head, nothing else there
+        return;
+    }
+
+    assert(0 == pending_size_);
+    points_ += other.points_;
+    points_in_circle_ += other.points_in_circle_;
+    std::copy(other.pending_, other.pending_ + other.pending_size_, pending_);
+    pending_size_ = other.pending_size_;
+}
+
+void MonteCarloPiAccumulator::report(const byte_histogram& counts, accumulator_results& results) const
+{
+    const double pi = boost::math::constants::pi<double>();
+    double monte_carlo_pi = points_ ? 4. * points_in_circle_ / points_ : 0.;
+    results.emplace_back("monte_carlo_pi", monte_carlo_pi);
+    results.emplace_back("monte_carlo_pi_error", 100. * std::fabs(pi - monte_carlo_pi) / pi);
+}
+
+void MonteCarloPiAccumulator::save(std::ostream& state) const
+{
+    state.write(reinterpret_cast<const char*>(head_), GROUP_SIZE);
+    write_field(state, head_size_);
+    write_field(state, head_needed_);
+    state.write(reinterpret_cast<const char*>(pending_), GROUP_SIZE);
+    write_field(state, pending_size_);
+    write_field(state, points_);
+    write_field(state, points_in_circle_);
+}
+
+void MonteCarloPiAccumulator::load(std::istream& state)
+{
+    state.read(reinterpret_cast<char*>(head_), GROUP_SIZE);
+    read_field(state, head_size_);
+    read_field(state, head_needed_);
+    state.read(reinterpret_cast<char*>(pending_), GROUP_SIZE);
+    read_field(state, pending_size_);
+    read_field(state, points_);
+    read_field(state, points_in_circle_);
+
+    if (head_size_ > GROUP_SIZE || head_needed_ > GROUP_SIZE || pending_size_ >= GROUP_SIZE) {
+        state.setstate(std::ios::failbit);
+    }
+}
+
+//
+// SerialCorrelationAccumulator
+//
+
+std::unique_ptr<BlockAccumulator> SerialCorrelationAccumulator::clone_empty(uintmax_t stream_offset) const
+{
+    return std::make_unique<SerialCorrelationAccumulator>();
+}
+
+void SerialCorrelationAccumulator::update(const uint8_t* block, size_t block_size)
+{
+    if (0 == block_size) {
+        return;
+    }
+
+    size_t i = 0;
+    if (!has_data_) {
+        first_ = last_ = block[0];
+        has_data_ = true;
+        i = 1;
+    }
+
+    uintmax_t products{};
+    uint32_t previous = last_;
+    for (; i < block_size; ++i) {
+        products += previous * block[i];
+        previous = block[i];
+    }
+
+    adjacent_products_ += products;
+    last_ = static_cast<uint8_t>(previous);
+}
+
+void SerialCorrelationAccumulator::merge(const BlockAccumulator& next)
+{
+    const auto& other = static_cast<const SerialCorrelationAccumulator&>(next);
+    if (!other.has_data_) {
+        return;
+    }
+    if (!has_data_) {
+        *this = other;
+        return;
+    }
+
+    adjacent_products_ += uintmax_t{ last_ } * other.first_ + other.adjacent_products_;
+    last_ = other.last_;
+}
+
+void SerialCorrelationAccumulator::report(const byte_histogram& counts, accumulator_results& results) const
+{
+    // Sums of bytes and of their squares come from the histogram
+    double total = static_cast<double>(histogram_total(counts));
+    double sum{};
+    double sum_squares{};
+    for (size_t i = 0; i != 256; ++i) {
+        sum += static_cast<double>(i * counts[i]);
+        sum_squares += static_cast<double>(i * i * counts[i]);
+    }
+
+    // wrap around: the last byte is followed by the first one
+    double products = static_cast<double>(adjacent_products_ + uintmax_t{ last_ } * first_);
+
+    double denominator = total * sum_squares - sum * sum;
+    if (!has_data_ || 0. == denominator) {
+        // all bytes are equal, correlation is undefined; `ent` reports the same value
+        results.emplace_back("serial_correlation", -100000.);
+        return;
+    }
+    results.emplace_back("serial_correlation", (total * products - sum * sum) / denominator);
+}
+
+void SerialCorrelationAccumulator::save(std::ostream& state) const
+{
+    write_field(state, has_data_);
+    write_field(state, first_);
+    write_field(state, last_);
+    write_field(state, adjacent_products_);
+}
+
+void SerialCorrelationAccumulator::load(std::istream& state)
+{
+    read_field(state, has_data_);
+    read_field(state, first_);
+    read_field(state, last_);
+    read_field(state, adjacent_products_);
+}
+
+//
+// AccumulatorSet
+//
+
+void AccumulatorSet::add(std::unique_ptr<BlockAccumulator> accumulator)
+{
+    accumulators_.push_back(std::move(accumulator));
+}
+
+AccumulatorSet AccumulatorSet::clone_empty(uintmax_t stream_offset) const
+{
+    AccumulatorSet empty_set;
+    for (const auto& accumulator : accumulators_) {
+        empty_set.add(accumulator->clone_empty(stream_offset));
+    }
+    return empty_set;
+}
+
+void AccumulatorSet::update(const uint8_t* block, size_t block_size)
+{
+    for (auto& accumulator : accumulators_) {
+        accumulator->update(block, block_size);
+    }
+}
+
+void AccumulatorSet::merge(const AccumulatorSet& next)
+{
+    assert(accumulators_.size() == next.accumulators_.size());
+    for (size_t i = 0; i != accumulators_.size(); ++i) {
+        accumulators_[i]->merge(*next.accumulators_[i]);
+    }
+}
+
+accumulator_results AccumulatorSet::report(const byte_histogram& counts) const
+{
+    accumulator_results results;
+    for (const auto& accumulator : accumulators_) {
+        accumulator->report(counts, results);
+    }
+    return results;
+}
+
+void AccumulatorSet::save(std::ostream& state) const
+{
+    write_field(state, accumulators_.size());
+    for (const auto& accumulator : accumulators_) {
+        std::string name = accumulator->name();
+        write_field(state, name.size());
+        state.write(name.data(), name.size());
+        accumulator->save(state);
+    }
+}
+
+bool AccumulatorSet::load(std::istream& state)
+{
+    size_t accumulators_count{};
+    read_field(state, accumulators_count);
+    if (!state || accumulators_count != accumulators_.size()) {
+        return false;
+    }
+
+    for (auto& accumulator : accumulators_) {
+        size_t name_size{};
+        read_field(state, name_size);
+        if (!state || name_size != std::strlen(accumulator->name())) {
+            return false;
+        }
+        std::string name(name_size, '\0');
+        state.read(&name[0], name_size);
+        if (!state || name != accumulator->name()) {
+            return false;
+        }
+        accumulator->load(state);
+    }
+    return static_cast<bool>(state);
+}
+
+AccumulatorSet AccumulatorSet::randomness_battery()
+{
+    AccumulatorSet battery;
+    battery.add(std::make_unique<ChiSquareAccumulator>());
+    battery.add(std::make_unique<ArithmeticMeanAccumulator>());
+    battery.add(std::make_unique<MonteCarloPiAccumulator>());
+    battery.add(std::make_unique<SerialCorrelationAccumulator>());
+    return battery;
+}
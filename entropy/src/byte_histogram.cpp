@@ -0,0 +1,64 @@
+#include <entropy/byte_histogram.h>
+#include <numeric>
+
+using namespace entropy;
+
+void entropy::count_bytes(const uint8_t* block, size_t block_size, byte_histogram& counts)
+{
+    // Four interleaved tables, so that runs of the same byte
+    // do not serialize on increments of the same counter
+    uint32_t partial[4][256] = {};
+
+    // 32-bit counters could overflow on huge blocks, flush them in slices
+    constexpr size_t SLICE_SIZE = size_t{ 1 } << 30;
+
+    while (block_size) {
+        size_t slice = block_size < SLICE_SIZE ? block_size : SLICE_SIZE;
+        size_t i = 0;
+        for (; i + 4 <= slice; i += 4) {
+            ++partial[0][block[i]];
+            ++partial[1][block[i + 1]];
+            ++partial[2][block[i + 2]];
+            ++partial[3][block[i + 3]];
+        }
+        for (; i < slice; ++i) {
+            ++partial[0][block[i]];
+        }
+
+        for (size_t b = 0; b != 256; ++b) {
+            counts[b] += uintmax_t{ partial[0][b] } + partial[1][b] + partial[2][b] + partial[3][b];
+            partial[0][b] = partial[1][b] = partial[2][b] = partial[3][b] = 0;
+        }
+
+        block += slice;
+        block_size -= slice;
+    }
+}
+
+void entropy::merge_histograms(byte_histogram& counts, const byte_histogram& other)
+{
+    for (size_t i = 0; i != 256; ++i) {
+        counts[i] += other[i];
+    }
+}
+
+uintmax_t entropy::histogram_total(const byte_histogram& counts)
+{
+    return std::accumulate(counts.begin(), counts.end(), uintmax_t{});
+}
+
+std::vector<double> entropy::histogram_probabilities(const byte_histogram& counts)
+{
+    std::vector<double> bytes_frequencies(256);
+    uintmax_t total = histogram_total(counts);
+
+    // probability of every byte of zero-sized sequence is 0
+    if (0 == total) {
+        return bytes_frequencies;
+    }
+
+    for (size_t i = 0; i != 256; ++i) {
+        bytes_frequencies[i] = static_cast<double>(counts[i]) / total;
+    }
+    return bytes_frequencies;
+}
@@ -0,0 +1,213 @@
+#include <entropy/content_chunker.h>
+#include <entropy/shannon_entropy.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace entropy;
+
+namespace {
+
+/// splitmix64, fills the Gear table with fixed pseudo-random values
+constexpr uint64_t splitmix64(uint64_t state)
+{
+    state += 0x9E3779B97F4A7C15ULL;
+    state = (state ^ (state >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    state = (state ^ (state >> 27)) * 0x94D049BB133111EBULL;
+    return state ^ (state >> 31);
+}
+
+struct GearTable {
+    uint64_t values[256]{};
+
+    constexpr GearTable()
+    {
+        for (size_t i = 0; i != 256; ++i) {
+            values[i] = splitmix64(i);
+        }
+    }
+};
+
+constexpr GearTable GEAR{};
+
+/// Mask of the highest bits_count bits, Gear hash shifts bytes towards high bits
+uint64_t high_bits_mask(unsigned bits_count)
+{
+    return bits_count ? ~uint64_t{} << (64 - bits_count) : 0;
+}
+
+unsigned log2_floor(size_t value)
+{
+    unsigned bits{};
+    while (value >>= 1) {
+        ++bits;
+    }
+    return bits;
+}
+
+/// MurmurHash64A, 8 bytes per step
+uint64_t chunk_hash(const uint8_t* data, size_t size)
+{
+    const uint64_t m = 0xC6A4A7935BD1E995ULL;
+    const int r = 47;
+    uint64_t hash = 0x5BD1E995ULL ^ (size * m);
+
+    const uint8_t* end = data + (size & ~size_t{ 7 });
+    for (; data != end; data += 8) {
+        uint64_t k;
+        std::memcpy(&k, data, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        hash ^= k;
+        hash *= m;
+    }
+
+    switch (size & 7) {
+    case 7: hash ^= uint64_t{ data[6] } << 48; // fall through
+    case 6: hash ^= uint64_t{ data[5] } << 40; // fall through
+    case 5: hash ^= uint64_t{ data[4] } << 32; // fall through
+    case 4: hash ^= uint64_t{ data[3] } << 24; // fall through
+    case 3: hash ^= uint64_t{ data[2] } << 16; // fall through
+    case 2: hash ^= uint64_t{ data[1] } << 8;  // fall through
+    case 1: hash ^= uint64_t{ data[0] };
+        hash *= m;
+    }
+
+    hash ^= hash >> r;
+    hash *= m;
+    hash ^= hash >> r;
+    return hash;
+}
+
+} // namespace
+
+ChunkingOptions ChunkingOptions::from_average(size_t average_size)
+{
+    ChunkingOptions options;
+    options.average_size = average_size;
+    options.min_size = average_size / 4;
+    options.max_size = average_size * 8;
+    return options;
+}
+
+ContentChunker::ContentChunker(const ChunkingOptions& options, chunk_callback_t on_chunk)
+    : options_(options)
+    , on_chunk_(std::move(on_chunk))
+{
+    if (options_.min_size > options_.average_size || options_.average_size > options_.max_size
+        || 0 == options_.average_size || options_.max_size > UINT32_MAX) {
+        throw std::invalid_argument("Chunk sizes should satisfy min <= average <= max < 4 GB");
+    }
+
+    // normalization level 2: two bits harder before the average size, two bits easier after it
+    unsigned bits = log2_floor(options_.average_size);
+    mask_small_ = high_bits_mask(std::min(bits + 2, 63u));
+    mask_large_ = high_bits_mask(bits > 2 ? bits - 2 : 1);
+
+    chunk_.reserve(options_.max_size);
+}
+
+size_t ContentChunker::find_boundary(const uint8_t* data, size_t data_size)
+{
+    boundary_found_ = false;
+    size_t chunk_size = chunk_.size();
+    size_t i = 0;
+
+    // cut-point skipping: no boundary could be before the min size, do not even hash
+    if (chunk_size < options_.min_size) {
+        i = std::min(options_.min_size - chunk_size, data_size);
+        chunk_size += i;
+    }
+
+    uint64_t fingerprint = fingerprint_;
+    for (; i < data_size; ++i) {
+        fingerprint = (fingerprint << 1) + GEAR.values[data[i]];
+        ++chunk_size;
+
+        uint64_t mask = chunk_size < options_.average_size ? mask_small_ : mask_large_;
+        if (0 == (fingerprint & mask) || chunk_size >= options_.max_size) {
+            boundary_found_ = true;
+            ++i;
+            break;
+        }
+    }
+
+    fingerprint_ = fingerprint;
+    return i;
+}
+
+void ContentChunker::update(const uint8_t* block, size_t block_size)
+{
+    while (block_size) {
+        size_t chunk_part = find_boundary(block, block_size);
+        chunk_.insert(chunk_.end(), block, block + chunk_part);
+        block += chunk_part;
+        block_size -= chunk_part;
+
+        if (boundary_found_) {
+            emit_chunk();
+        }
+    }
+}
+
+void ContentChunker::finish()
+{
+    if (!chunk_.empty()) {
+        emit_chunk();
+    }
+}
+
+void ContentChunker::emit_chunk()
+{
+    ChunkRecord record;
+    record.offset = summary_.total_bytes;
+    record.size = chunk_.size();
+    record.hash = chunk_hash(chunk_.data(), chunk_.size());
+
+    auto found = chunks_.find(record.hash);
+    record.duplicate = (found != chunks_.end() && found->second.size == record.size);
+
+    if (record.duplicate && found->second.histogram_index != NOT_CACHED) {
+        // reuse cached histogram, chunk bytes are not counted again
+        const chunk_histogram& cached = cached_histograms_[found->second.histogram_index];
+        for (size_t i = 0; i != 256; ++i) {
+            summary_.counts[i] += cached[i];
+        }
+        record.entropy = found->second.entropy;
+    }
+    else {
+        byte_histogram counts{};
+        count_bytes(chunk_.data(), chunk_.size(), counts);
+        merge_histograms(summary_.counts, counts);
+        record.entropy = histogram_entropy(counts);
+
+        if (found == chunks_.end() && chunks_.size() >= options_.max_indexed_chunks) {
+            ++summary_.unindexed_chunks_count;
+        }
+        else if (found == chunks_.end()) {
+            CachedChunk cached{ record.size, record.entropy, NOT_CACHED };
+            if (cached_histograms_.size() < options_.max_cached_histograms) {
+                cached.histogram_index = cached_histograms_.size();
+                cached_histograms_.emplace_back();
+                std::copy(counts.begin(), counts.end(), cached_histograms_.back().begin());
+            }
+            chunks_.emplace(record.hash, cached);
+        }
+        // else hash collision of chunks of different size, counted as unique
+    }
+
+    summary_.total_bytes += record.size;
+    ++summary_.chunks_count;
+    if (!record.duplicate) {
+        summary_.unique_bytes += record.size;
+        ++summary_.unique_chunks_count;
+    }
+
+    if (on_chunk_) {
+        on_chunk_(record);
+    }
+
+    chunk_.clear();
+    fingerprint_ = 0;
+}
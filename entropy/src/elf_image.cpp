@@ -0,0 +1,246 @@
+#include <entropy/elf_image.h>
+#include <cstring>
+#include <stdexcept>
+
+using namespace entropy;
+
+namespace {
+
+constexpr uint8_t ELF_MAGIC[] = { 0x7f, 'E', 'L', 'F' };
+
+// e_ident fields
+constexpr size_t EI_CLASS = 4;
+constexpr size_t EI_DATA = 5;
+constexpr uint8_t ELFCLASS32 = 1;
+constexpr uint8_t ELFCLASS64 = 2;
+constexpr uint8_t ELFDATA2LSB = 1;
+constexpr uint8_t ELFDATA2MSB = 2;
+
+constexpr size_t ELF32_HEADER_SIZE = 52;
+constexpr size_t ELF64_HEADER_SIZE = 64;
+constexpr size_t ELF32_SECTION_SIZE = 40;
+constexpr size_t ELF64_SECTION_SIZE = 64;
+constexpr size_t ELF32_SEGMENT_SIZE = 32;
+constexpr size_t ELF64_SEGMENT_SIZE = 56;
+
+// section table indexes above this are stored in the section 0 (extended numbering)
+constexpr uint32_t SHN_XINDEX = 0xffff;
+constexpr uint32_t PN_XNUM = 0xffff;
+
+constexpr uint32_t SHT_NOBITS = 8;
+
+constexpr uint64_t SHF_WRITE = 0x1;
+constexpr uint64_t SHF_ALLOC = 0x2;
+constexpr uint64_t SHF_EXECINSTR = 0x4;
+
+constexpr uint64_t PF_X = 0x1;
+constexpr uint64_t PF_W = 0x2;
+constexpr uint64_t PF_R = 0x4;
+
+} // namespace
+
+ElfImage::ElfImage(const uint8_t* image, size_t image_size)
+    : image_(image)
+    , image_size_(image_size)
+{
+    if (!is_elf(image, image_size)) {
+        throw std::runtime_error("Not an ELF image");
+    }
+    if (ELFCLASS32 != image[EI_CLASS] && ELFCLASS64 != image[EI_CLASS]) {
+        throw std::runtime_error("Unknown ELF class");
+    }
+    if (ELFDATA2LSB != image[EI_DATA] && ELFDATA2MSB != image[EI_DATA]) {
+        throw std::runtime_error("Unknown ELF byte order");
+    }
+    is_64bit_ = ELFCLASS64 == image[EI_CLASS];
+    is_little_endian_ = ELFDATA2LSB == image[EI_DATA];
+
+    if (image_size < (is_64bit_ ? ELF64_HEADER_SIZE : ELF32_HEADER_SIZE)) {
+        throw std::runtime_error("ELF header is truncated");
+    }
+
+    // fields after e_entry are shifted by the word size
+    const uint64_t word = is_64bit_ ? 8 : 4;
+    machine_ = read<uint16_t>(18);
+    uint64_t segments_offset = read_word(24 + word);
+    uint64_t sections_offset = read_word(24 + 2 * word);
+    const uint64_t sizes = 24 + 3 * word + 4 + 2;
+    uint64_t segment_size = read<uint16_t>(sizes);
+    uint64_t segments_count = read<uint16_t>(sizes + 2);
+    uint64_t section_size = read<uint16_t>(sizes + 4);
+    uint64_t sections_count = read<uint16_t>(sizes + 6);
+    uint32_t names_index = read<uint16_t>(sizes + 8);
+
+    // extended numbering: real values are in the section 0
+    if (sections_offset && (0 == sections_count || SHN_XINDEX == names_index || PN_XNUM == segments_count)) {
+        check_table(sections_offset, 1, section_size, section_header_size(), "section");
+        if (0 == sections_count) {
+            sections_count = read_word(sections_offset + (is_64bit_ ? 32 : 20));
+        }
+        if (SHN_XINDEX == names_index) {
+            names_index = read<uint32_t>(sections_offset + (is_64bit_ ? 40 : 24));
+        }
+        if (PN_XNUM == segments_count) {
+            segments_count = read<uint32_t>(sections_offset + (is_64bit_ ? 44 : 28));
+        }
+    }
+
+    if (sections_offset && sections_count) {
+        read_sections(sections_offset, sections_count, section_size, names_index);
+    }
+    if (segments_offset && segments_count) {
+        read_segments(segments_offset, segments_count, segment_size);
+    }
+}
+
+bool ElfImage::is_elf(const uint8_t* image, size_t image_size)
+{
+    return image_size >= sizeof(ELF_MAGIC) && 0 == std::memcmp(image, ELF_MAGIC, sizeof(ELF_MAGIC));
+}
+
+std::string ElfImage::flags_description(const ElfRegion& region)
+{
+    std::string description;
+    if (ElfRegion::Section == region.kind) {
+        if (region.flags & SHF_WRITE) description += 'W';
+        if (region.flags & SHF_ALLOC) description += 'A';
+        if (region.flags & SHF_EXECINSTR) description += 'X';
+    }
+    else {
+        description += (region.flags & PF_R) ? 'R' : '-';
+        description += (region.flags & PF_W) ? 'W' : '-';
+        description += (region.flags & PF_X) ? 'E' : '-';
+    }
+    return description;
+}
+
+template <typename T>
+T ElfImage::read(uint64_t offset) const
+{
+    T value{};
+    for (size_t i = 0; i != sizeof(T); ++i) {
+        size_t shift = is_little_endian_ ? i : sizeof(T) - 1 - i;
+        value |= static_cast<T>(static_cast<T>(image_[offset + i]) << (8 * shift));
+    }
+    return value;
+}
+
+uint64_t ElfImage::section_header_size() const
+{
+    return is_64bit_ ? ELF64_SECTION_SIZE : ELF32_SECTION_SIZE;
+}
+
+uint64_t ElfImage::read_word(uint64_t offset) const
+{
+    return is_64bit_ ? read<uint64_t>(offset) : read<uint32_t>(offset);
+}
+
+void ElfImage::check_table(uint64_t offset, uint64_t entries_count, uint64_t entry_size, 
+    uint64_t min_entry_size, const char* table) const
+{
+    if (entry_size < min_entry_size) {
+        throw std::runtime_error(std::string("ELF ") + table + " header size is too small");
+    }
+    // division instead of multiplication, count comes from the file and may overflow
+    if (offset > image_size_ || entries_count > (image_size_ - offset) / entry_size) {
+        throw std::runtime_error(std::string("ELF ") + table + " headers table is out of the file");
+    }
+}
+
+void ElfImage::set_range(ElfRegion& region, uint64_t offset, uint64_t size) const
+{
+    region.offset = offset < image_size_ ? offset : image_size_;
+    region.size = size < image_size_ - region.offset ? size : image_size_ - region.offset;
+    region.truncated = region.size != size;
+}
+
+void ElfImage::read_sections(uint64_t table_offset, uint64_t entries_count, uint64_t entry_size, uint32_t names_index)
+{
+    check_table(table_offset, entries_count, entry_size, section_header_size(), "section");
+
+    // field offsets of Elf64_Shdr / Elf32_Shdr
+    const uint64_t flags_field = 8;
+    const uint64_t offset_field = is_64bit_ ? 24 : 16;
+    const uint64_t size_field = is_64bit_ ? 32 : 20;
+
+    uint64_t names_offset{};
+    uint64_t names_size{};
+    if (names_index < entries_count) {
+        uint64_t names_header = table_offset + names_index * entry_size;
+        names_offset = read_word(names_header + offset_field);
+        names_size = read_word(names_header + size_field);
+    }
+
+    // section 0 is reserved
+    sections_.reserve(static_cast<size_t>(entries_count - 1));
+    for (uint64_t i = 1; i < entries_count; ++i) {
+        uint64_t header = table_offset + i * entry_size;
+
+        ElfRegion section;
+        section.kind = ElfRegion::Section;
+        section.name = section_name(names_offset, names_size, read<uint32_t>(header));
+        section.type = read<uint32_t>(header + 4);
+        section.flags = read_word(header + flags_field);
+        uint64_t file_size = SHT_NOBITS == section.type ? 0 : read_word(header + size_field);
+        set_range(section, read_word(header + offset_field), file_size);
+        sections_.push_back(section);
+    }
+}
+
+void ElfImage::read_segments(uint64_t table_offset, uint64_t entries_count, uint64_t entry_size)
+{
+    check_table(table_offset, entries_count, entry_size, 
+        is_64bit_ ? ELF64_SEGMENT_SIZE : ELF32_SEGMENT_SIZE, "segment");
+
+    // p_flags is the second field of Elf64_Phdr, but the 7th one of Elf32_Phdr
+    const uint64_t flags_field = is_64bit_ ? 4 : 24;
+    const uint64_t offset_field = is_64bit_ ? 8 : 4;
+    const uint64_t size_field = is_64bit_ ? 32 : 16;
+
+    segments_.reserve(static_cast<size_t>(entries_count));
+    for (uint64_t i = 0; i < entries_count; ++i) {
+        uint64_t header = table_offset + i * entry_size;
+
+        ElfRegion segment;
+        segment.kind = ElfRegion::Segment;
+        segment.type = read<uint32_t>(header);
+        segment.name = segment_name(segment.type);
+        segment.flags = read<uint32_t>(header + flags_field);
+        set_range(segment, read_word(header + offset_field), read_word(header + size_field));
+        segments_.push_back(segment);
+    }
+}
+
+const char* ElfImage::section_name(uint64_t names_offset, uint64_t names_size, uint32_t name_offset) const
+{
+    if (names_offset >= image_size_ || name_offset >= names_size) {
+        return "";
+    }
+    // name should be null-terminated inside both the table and the image
+    uint64_t table_end = names_size < image_size_ - names_offset ? names_offset + names_size : image_size_;
+    const uint8_t* name = image_ + names_offset + name_offset;
+    if (names_offset + name_offset >= table_end
+        || nullptr == std::memchr(name, 0, static_cast<size_t>(table_end - names_offset - name_offset))) {
+        return "";
+    }
+    return reinterpret_cast<const char*>(name);
+}
+
+const char* ElfImage::segment_name(uint32_t type)
+{
+    switch (type) {
+    case 0: return "NULL";
+    case 1: return "LOAD";
+    case 2: return "DYNAMIC";
+    case 3: return "INTERP";
+    case 4: return "NOTE";
+    case 5: return "SHLIB";
+    case 6: return "PHDR";
+    case 7: return "TLS";
+    case 0x6474e550: return "GNU_EH_FRAME";
+    case 0x6474e551: return "GNU_STACK";
+    case 0x6474e552: return "GNU_RELRO";
+    case 0x6474e553: return "GNU_PROPERTY";
+    default: return "OTHER";
+    }
+}
@@ -0,0 +1,116 @@
+#include <entropy/entropy_aggregator.h>
+#include <algorithm>
+#include <cctype>
+
+using namespace entropy;
+
+const char* const EntropyAggregator::OTHER_GROUP = "(other)";
+
+//
+// GroupStatistics
+//
+
+void GroupStatistics::add(double file_entropy, const byte_histogram& file_counts)
+{
+    ++files_count;
+    merge_histograms(counts, file_counts);
+    entropy.add(file_entropy);
+}
+
+void GroupStatistics::merge(const GroupStatistics& other)
+{
+    files_count += other.files_count;
+    merge_histograms(counts, other.counts);
+    entropy.merge(other.entropy);
+}
+
+//
+// EntropyAggregator
+//
+
+EntropyAggregator::EntropyAggregator(size_t directory_depth, size_t max_groups)
+    : directory_depth_(directory_depth)
+    , max_groups_(std::max<size_t>(max_groups, 1))
+{
+}
+
+GroupStatistics& EntropyAggregator::group(groups_t& groups, const std::string& key)
+{
+    auto found = groups.find(key);
+    if (found != groups.end()) {
+        return found->second;
+    }
+
+    // one slot is reserved for the overflow group
+    if (groups.size() + 1 >= max_groups_) {
+        return groups[OTHER_GROUP];
+    }
+    return groups[key];
+}
+
+std::string EntropyAggregator::size_class(uintmax_t file_size)
+{
+    static const char* const units[] = { "", "K", "M", "G", "T", "P", "E" };
+
+    if (0 == file_size) {
+        return "--: 0";
+    }
+
+    unsigned bits{};
+    while (file_size >>= 1) {
+        ++bits;
+    }
+
+    auto power_name = [](unsigned power) {
+        return std::to_string(uintmax_t{ 1 } << (power % 10)) + units[power / 10];
+    };
+    // leading power of two keeps classes sorted
+    std::string power = std::to_string(bits);
+    return std::string(2 - std::min<size_t>(power.size(), 2), '0') + power + ": " 
+        + power_name(bits) + "-" + power_name(bits + 1);
+}
+
+void EntropyAggregator::add(const std::string& relative_path, double file_entropy, const byte_histogram& file_counts)
+{
+    total_.add(file_entropy, file_counts);
+
+    size_t name_start = relative_path.rfind('/');
+    name_start = (std::string::npos == name_start) ? 0 : name_start + 1;
+
+    // extension is case-insensitive, hidden files without extension are not ".name"
+    std::string extension;
+    size_t dot = relative_path.rfind('.');
+    if (dot != std::string::npos && dot > name_start) {
+        extension = relative_path.substr(dot);
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    }
+    group(extensions_, extension.empty() ? "(none)" : extension).add(file_entropy, file_counts);
+
+    // file is accounted in every enclosing subtree up to the depth
+    size_t separator = 0;
+    for (size_t depth = 0; depth != directory_depth_; ++depth) {
+        separator = relative_path.find('/', separator);
+        if (std::string::npos == separator) {
+            break;
+        }
+        group(directories_, relative_path.substr(0, separator)).add(file_entropy, file_counts);
+        ++separator;
+    }
+
+    group(size_classes_, size_class(histogram_total(file_counts))).add(file_entropy, file_counts);
+}
+
+void EntropyAggregator::merge(const EntropyAggregator& other)
+{
+    total_.merge(other.total_);
+    for (const auto& extension : other.extensions_) {
+        group(extensions_, extension.first).merge(extension.second);
+    }
+    for (const auto& directory : other.directories_) {
+        group(directories_, directory.first).merge(directory.second);
+    }
+    for (const auto& size_class : other.size_classes_) {
+        group(size_classes_, size_class.first).merge(size_class.second);
+    }
+}
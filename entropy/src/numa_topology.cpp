@@ -0,0 +1,96 @@
+#include <entropy/numa_topology.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace entropy;
+
+namespace {
+
+/// Parse sysfs CPU list, e.g. "0-3,8-11"
+std::vector<int> parse_cpu_list(const std::string& cpu_list)
+{
+    std::vector<int> cpus;
+    std::istringstream ranges(cpu_list);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        int first{};
+        int last{};
+        char dash{};
+        std::istringstream bounds(range);
+        if (!(bounds >> first)) {
+            continue;
+        }
+        if (!(bounds >> dash >> last) || '-' != dash) {
+            last = first;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+} // namespace
+
+NumaTopology NumaTopology::detect()
+{
+    NumaTopology topology;
+#if defined(__linux__)
+    // node numbers may have gaps, stop after a long run of missing ones
+    constexpr int MAX_MISSING_NODES = 64;
+    for (int node = 0, missing = 0; missing < MAX_MISSING_NODES; ++node) {
+        std::ifstream cpu_list_file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string cpu_list;
+        if (!cpu_list_file || !std::getline(cpu_list_file, cpu_list)) {
+            ++missing;
+            continue;
+        }
+        missing = 0;
+
+        // memory-only nodes have no CPUs to run workers on
+        std::vector<int> cpus = parse_cpu_list(cpu_list);
+        if (!cpus.empty()) {
+            topology.nodes_.push_back(std::move(cpus));
+        }
+    }
+
+    // pinning is useless on the single node
+    if (topology.nodes_.size() < 2) {
+        topology.nodes_.clear();
+    }
+#endif
+    return topology;
+}
+
+size_t NumaTopology::worker_node(size_t worker_index, size_t workers_count) const
+{
+    if (0 == workers_count) {
+        return 0;
+    }
+    return worker_index * nodes_count() / workers_count;
+}
+
+bool NumaTopology::pin_current_thread(size_t node) const
+{
+#if defined(__linux__)
+    if (node >= nodes_.size()) {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : nodes_[node]) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    return 0 == ::pthread_setaffinity_np(::pthread_self(), sizeof(cpu_set), &cpu_set);
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,149 @@
+#include <entropy/quantile_sketch.h>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace entropy;
+
+QuantileSketch::QuantileSketch(size_t k)
+    : k_(std::max<size_t>(k, 8))
+{
+    grow();
+}
+
+size_t QuantileSketch::capacity(size_t level) const
+{
+    // lower levels shrink geometrically, the top one holds k values
+    size_t depth = levels_.size() - level - 1;
+    return static_cast<size_t>(std::ceil(std::pow(2. / 3., static_cast<double>(depth)) * k_)) + 1;
+}
+
+void QuantileSketch::grow()
+{
+    levels_.emplace_back();
+    max_stored_ = 0;
+    for (size_t level = 0; level != levels_.size(); ++level) {
+        max_stored_ += capacity(level);
+    }
+}
+
+size_t QuantileSketch::stored() const
+{
+    size_t values_count{};
+    for (const auto& level : levels_) {
+        values_count += level.size();
+    }
+    return values_count;
+}
+
+void QuantileSketch::add(double value)
+{
+    if (0 == count_) {
+        min_ = max_ = value;
+    }
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += value;
+    ++count_;
+
+    levels_[0].push_back(value);
+    if (stored() >= max_stored_) {
+        compress();
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch& other)
+{
+    if (0 == other.count_) {
+        return;
+    }
+    if (0 == count_) {
+        min_ = other.min_;
+        max_ = other.max_;
+    }
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+    count_ += other.count_;
+
+    while (levels_.size() < other.levels_.size()) {
+        grow();
+    }
+    for (size_t level = 0; level != other.levels_.size(); ++level) {
+        levels_[level].insert(levels_[level].end(), other.levels_[level].begin(), other.levels_[level].end());
+    }
+    while (stored() >= max_stored_) {
+        compress();
+    }
+}
+
+void QuantileSketch::compress()
+{
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        if (levels_[level].size() >= capacity(level)) {
+            if (level + 1 == levels_.size()) {
+                grow();
+            }
+            compact(level);
+            if (stored() < max_stored_) {
+                break;
+            }
+        }
+    }
+}
+
+void QuantileSketch::compact(size_t level)
+{
+    std::vector<double>& values = levels_[level];
+    std::sort(values.begin(), values.end());
+
+    // xorshift64 coin: keep odd or even positions
+    coin_state_ ^= coin_state_ << 13;
+    coin_state_ ^= coin_state_ >> 7;
+    coin_state_ ^= coin_state_ << 17;
+    size_t offset = coin_state_ & 1;
+
+    // odd value is left on this level
+    size_t compacted_size = values.size() & ~size_t{ 1 };
+    std::vector<double>& next = levels_[level + 1];
+    for (size_t i = offset; i < compacted_size; i += 2) {
+        next.push_back(values[i]);
+    }
+
+    if (compacted_size != values.size()) {
+        values[0] = values.back();
+        values.resize(1);
+    }
+    else {
+        values.clear();
+    }
+}
+
+double QuantileSketch::quantile(double quantile) const
+{
+    if (0 == count_) {
+        return 0.;
+    }
+
+    std::vector<std::pair<double, uintmax_t>> weighted;
+    weighted.reserve(stored());
+    uintmax_t total_weight{};
+    for (size_t level = 0; level != levels_.size(); ++level) {
+        uintmax_t weight = uintmax_t{ 1 } << level;
+        for (double value : levels_[level]) {
+            weighted.emplace_back(value, weight);
+            total_weight += weight;
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+
+    double rank = std::min(std::max(quantile, 0.), 1.) * total_weight;
+    uintmax_t seen{};
+    for (const auto& item : weighted) {
+        seen += item.second;
+        if (seen >= rank) {
+            return item.first;
+        }
+    }
+    return max_;
+}
@@ -0,0 +1,197 @@
+#include <entropy/scan_checkpoint.h>
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+using namespace entropy;
+namespace fs = boost::filesystem;
+
+namespace {
+
+const char CHECKPOINT_MAGIC[8] = { 'E', 'N', 'T', 'C', 'K', 'P', 'T', '1' };
+const char INCREMENTAL_MAGIC[8] = { 'E', 'N', 'T', 'I', 'N', 'C', 'R', '1' };
+
+const char CHECKPOINT_SUFFIX[] = ".entropy-checkpoint";
+const char INCREMENTAL_SUFFIX[] = ".entropy-state";
+const char TEMPORARY_SUFFIX[] = ".tmp";
+
+bool ends_with(const std::string& text, const std::string& suffix)
+{
+    return text.size() >= suffix.size() && 0 == text.compare(text.size() - suffix.size(), suffix.size(), suffix);
+}
+
+template <typename T>
+void append_field(std::string& data, const T& value)
+{
+    data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool extract_field(const std::string& data, size_t& position, T& value)
+{
+    if (data.size() - position < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, data.data() + position, sizeof(value));
+    position += sizeof(value);
+    return true;
+}
+
+/// FNV-1a
+uint64_t fnv1a(const uint8_t* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i != size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/// Detects torn or damaged sidecar file
+uint64_t checksum(const std::string& data)
+{
+    return fnv1a(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+/// Append checksum and write the sidecar file, rename replaces the previous one atomically
+void write_sidecar(const std::string& path, std::string& data)
+{
+    append_field(data, checksum(data));
+
+    std::string temporary_path = path + ".tmp";
+    {
+        std::ofstream sidecar_file(temporary_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        sidecar_file.write(data.data(), data.size());
+        sidecar_file.flush();
+        if (!sidecar_file) {
+            sidecar_file.close();
+            boost::system::error_code error;
+            fs::remove(temporary_path, error);
+            throw std::runtime_error("Unable to write " + temporary_path);
+        }
+    }
+    fs::rename(temporary_path, path);
+}
+
+/// Read the sidecar file, check magic and checksum
+/// @return false if there is no file or it is damaged, data without checksum otherwise
+bool read_sidecar(const std::string& path, const char (&magic)[8], std::string& data)
+{
+    std::ifstream sidecar_file(path, std::ios::in | std::ios::binary);
+    if (!sidecar_file) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(sidecar_file), std::istreambuf_iterator<char>());
+
+    uint64_t stored_checksum{};
+    if (data.size() < sizeof(magic) + sizeof(stored_checksum)
+        || 0 != std::memcmp(data.data(), magic, sizeof(magic))) {
+        return false;
+    }
+    std::memcpy(&stored_checksum, data.data() + data.size() - sizeof(stored_checksum), sizeof(stored_checksum));
+    data.resize(data.size() - sizeof(stored_checksum));
+    return checksum(data) == stored_checksum;
+}
+
+} // namespace
+
+void ScanCheckpoint::save(const std::string& checkpoint_path) const
+{
+    std::string data(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    append_field(data, file_size);
+    append_field(data, last_write_time);
+    append_field(data, offset);
+    for (uintmax_t count : counts) {
+        append_field(data, count);
+    }
+    append_field(data, accumulators_state.size());
+    data += accumulators_state;
+    write_sidecar(checkpoint_path, data);
+}
+
+bool ScanCheckpoint::load(const std::string& checkpoint_path)
+{
+    std::string data;
+    if (!read_sidecar(checkpoint_path, CHECKPOINT_MAGIC, data)) {
+        return false;
+    }
+
+    size_t position = sizeof(CHECKPOINT_MAGIC);
+    size_t state_size{};
+    bool parsed = extract_field(data, position, file_size)
+        && extract_field(data, position, last_write_time)
+        && extract_field(data, position, offset);
+    for (uintmax_t& count : counts) {
+        parsed = parsed && extract_field(data, position, count);
+    }
+    parsed = parsed && extract_field(data, position, state_size) && (data.size() - position == state_size);
+    if (!parsed) {
+        return false;
+    }
+
+    accumulators_state = data.substr(position);
+    return histogram_total(counts) == offset;
+}
+
+std::string ScanCheckpoint::sidecar_path(const std::string& file_path)
+{
+    return file_path + CHECKPOINT_SUFFIX;
+}
+
+void IncrementalState::save(const std::string& state_path) const
+{
+    std::string data(INCREMENTAL_MAGIC, sizeof(INCREMENTAL_MAGIC));
+    append_field(data, file_size);
+    append_field(data, tail_size);
+    append_field(data, tail_hash);
+    for (uintmax_t count : counts) {
+        append_field(data, count);
+    }
+    append_field(data, accumulators_state.size());
+    data += accumulators_state;
+    write_sidecar(state_path, data);
+}
+
+bool IncrementalState::load(const std::string& state_path)
+{
+    std::string data;
+    if (!read_sidecar(state_path, INCREMENTAL_MAGIC, data)) {
+        return false;
+    }
+
+    size_t position = sizeof(INCREMENTAL_MAGIC);
+    size_t state_size{};
+    bool parsed = extract_field(data, position, file_size)
+        && extract_field(data, position, tail_size)
+        && extract_field(data, position, tail_hash);
+    for (uintmax_t& count : counts) {
+        parsed = parsed && extract_field(data, position, count);
+    }
+    parsed = parsed && extract_field(data, position, state_size) && (data.size() - position == state_size);
+    if (!parsed) {
+        return false;
+    }
+
+    accumulators_state = data.substr(position);
+    return histogram_total(counts) == file_size && tail_size <= file_size && tail_size <= MAX_TAIL_SIZE;
+}
+
+std::string IncrementalState::sidecar_path(const std::string& file_path)
+{
+    return file_path + INCREMENTAL_SUFFIX;
+}
+
+bool entropy::is_scan_sidecar(const std::string& file_path)
+{
+    std::string path = ends_with(file_path, TEMPORARY_SUFFIX)
+        ? file_path.substr(0, file_path.size() - (sizeof(TEMPORARY_SUFFIX) - 1)) : file_path;
+    return ends_with(path, CHECKPOINT_SUFFIX) || ends_with(path, INCREMENTAL_SUFFIX);
+}
+
+uint64_t IncrementalState::block_hash(const uint8_t* block, size_t block_size)
+{
+    return fnv1a(block, block_size);
+}
@@ -1,13 +1,18 @@
+#include <entropy/uint8_codecvt.h>
 #include <entropy/shannon_entropy.h>
+#include <entropy/scan_checkpoint.h>
 #include <boost/filesystem.hpp>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
 #include <cassert>
+#include <limits>
 
 using namespace entropy;
 using namespace std;
 namespace fs = boost::filesystem;
 
-bool entropy::ShannonEncryptionChecker::interrupt_all_ = false;
+std::atomic<bool> entropy::ShannonEncryptionChecker::interrupt_all_{ false };
 bool entropy::ShannonEncryptionChecker::load_uint8_codecvt_;
 
 std::map<ShannonEncryptionChecker::InformationEntropyEstimation, std::string> 
@@ -28,7 +33,17 @@ ShannonEncryptionChecker::ShannonEncryptionChecker()
 
 void ShannonEncryptionChecker::interrupt()
 {
-    interrupt_all_ = true;
+    interrupt_all_.store(true, std::memory_order_relaxed);
+}
+
+bool ShannonEncryptionChecker::is_interrupted()
+{
+    return interrupt_all_.load(std::memory_order_relaxed);
+}
+
+bool ShannonEncryptionChecker::is_stopped() const
+{
+    return is_interrupted() || (stop_flag_ && stop_flag_->load(std::memory_order_relaxed));
 }
 
 std::string ShannonEncryptionChecker::get_information_description(InformationEntropyEstimation ent) const
@@ -45,6 +60,29 @@ size_t ShannonEncryptionChecker::min_compressed_size(double entropy, size_t sequ
     return static_cast<size_t>((entropy * sequence_size) / 8);
 }
 
+namespace {
+
+using binary_ifstream = std::basic_ifstream<uint8_t, std::char_traits<uint8_t>>;
+
+/// Hash of the file block [end - block_size, end), stream position is changed
+/// @return false if the block could not be read or does not fit the buffer
+bool read_block_hash(binary_ifstream& file, uintmax_t end, uintmax_t block_size, uint8_t* buffer, size_t buffer_size, uint64_t& hash)
+{
+    if (block_size > buffer_size || block_size > end) {
+        return false;
+    }
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(end - block_size));
+    file.read(buffer, static_cast<std::streamsize>(block_size));
+    if (static_cast<uintmax_t>(file.gcount()) != block_size) {
+        return false;
+    }
+    hash = IncrementalState::block_hash(buffer, static_cast<size_t>(block_size));
+    return true;
+}
+
+} // namespace
+
 double entropy::ShannonEncryptionChecker::get_file_entropy(const std::string& file_path) const
 {
     uintmax_t file_size = fs::file_size(file_path);
@@ -52,18 +90,89 @@ double entropy::ShannonEncryptionChecker::get_file_entropy(const std::string& fi
     return shannon_entropy(byte_probabilities.begin(), byte_probabilities.end());
 }
 
+double ShannonEncryptionChecker::get_file_entropy(const std::string& file_path, AccumulatorSet& accumulators, byte_histogram& counts,
+    uintmax_t* restored_bytes) const
+{
+    counts = byte_histogram{};
+    if (!read_file_counts(file_path, counts, &accumulators, restored_bytes)) {
+        return 0.;
+    }
+    std::vector<double> byte_probabilities = histogram_probabilities(counts);
+    return shannon_entropy(byte_probabilities.begin(), byte_probabilities.end());
+}
+
+double ShannonEncryptionChecker::get_file_head_entropy(const std::string& file_path, uintmax_t head_size, byte_histogram& counts) const
+{
+    counts = byte_histogram{};
+    bool completed = read_file_blocks(file_path, [&counts](const uint8_t* block, size_t block_size) {
+        count_bytes(block, block_size, counts);
+    }, head_size);
+    if (!completed) {
+        return 0.;
+    }
+    return histogram_entropy(counts);
+}
+
+double ShannonEncryptionChecker::get_file_chunks_entropy(const std::string& file_path, ContentChunker& chunker, 
+    AccumulatorSet& accumulators) const
+{
+    bool completed = read_file_blocks(file_path, [&](const uint8_t* block, size_t block_size) {
+        chunker.update(block, block_size);
+        if (!accumulators.empty()) {
+            accumulators.update(block, block_size);
+        }
+    });
+    if (!completed) {
+        return 0.;
+    }
+
+    chunker.finish();
+    return histogram_entropy(chunker.summary().counts);
+}
 
 void ShannonEncryptionChecker::set_callback(callback_t callback)
 {
     callback_ = callback;
 }
 
+void ShannonEncryptionChecker::set_sidecar_error_callback(sidecar_error_callback_t callback)
+{
+    sidecar_error_callback_ = callback;
+}
+
+void ShannonEncryptionChecker::set_stop_flag(const std::atomic<bool>* stop_flag)
+{
+    stop_flag_ = stop_flag;
+}
+
+void ShannonEncryptionChecker::set_checkpoint(uintmax_t checkpoint_interval, bool resume)
+{
+    checkpoint_interval_ = checkpoint_interval;
+    resume_ = resume;
+}
+
+void ShannonEncryptionChecker::set_incremental(bool incremental)
+{
+    incremental_ = incremental;
+}
+
 double ShannonEncryptionChecker::get_sequence_entropy(const uint8_t* sequence_start, size_t sequence_size) const
 {
     std::vector<double> byte_probabilities = read_stream_probabilities(sequence_start, sequence_size);
     return shannon_entropy(byte_probabilities.begin(), byte_probabilities.end());
 }
 
+double ShannonEncryptionChecker::get_sequence_entropy(const uint8_t* sequence_start, size_t sequence_size,
+    AccumulatorSet& accumulators, byte_histogram& counts) const
+{
+    counts = byte_histogram{};
+    if (!read_stream_counts(sequence_start, sequence_size, counts, &accumulators)) {
+        return 0.;
+    }
+    std::vector<double> byte_probabilities = histogram_probabilities(counts);
+    return shannon_entropy(byte_probabilities.begin(), byte_probabilities.end());
+}
+
 ShannonEncryptionChecker::InformationEntropyEstimation
 ShannonEncryptionChecker::information_entropy_estimation(double entropy, size_t sequence_size) const
 {
@@ -89,70 +198,336 @@ std::vector<double> ShannonEncryptionChecker::read_file_probabilities(const std:
         return std::vector<double>(256);
     }
 
-    uint8_t read_ahead_buffer[MAX_BUFFER_SIZE];
+    byte_histogram counts{};
+    if (!read_file_counts(file_path, counts, nullptr)) {
+        return std::vector<double>{};
+    }
+    return histogram_probabilities(counts);
+}
 
-    std::vector<size_t> bytes_distribution(256);
-    std::vector<double> bytes_frequencies(256);
-    std::basic_ifstream<uint8_t, std::char_traits<uint8_t>> file(file_path, std::ios::in | std::ios::binary);
-    file.rdbuf()->pubsetbuf(read_ahead_buffer, MAX_BUFFER_SIZE);
+std::vector<double> ShannonEncryptionChecker::read_stream_probabilities(const uint8_t* sequence_start, size_t sequence_size) const
+{
+    if (0 == sequence_size) {
+        return std::vector<double>(256);
+    }
+
+    byte_histogram counts{};
+    if (!read_stream_counts(sequence_start, sequence_size, counts, nullptr)) {
+        return std::vector<double>{};
+    }
+    return histogram_probabilities(counts);
+}
+
+bool ShannonEncryptionChecker::read_file_counts(const std::string& file_path, byte_histogram& counts, AccumulatorSet* accumulators,
+    uintmax_t* restored_bytes) const
+{
+    uint8_t read_buffer[MAX_BUFFER_SIZE];
+
+    binary_ifstream file;
+    // read whole blocks directly into our buffer, stream buffering is only an extra copy
+    file.rdbuf()->pubsetbuf(nullptr, 0);
+    file.open(file_path, std::ios::in | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open file " + file_path);
+    }
+
+    // state of empty accumulators set is written if there are no accumulators
+    AccumulatorSet no_accumulators;
+    AccumulatorSet& checkpoint_accumulators = accumulators ? *accumulators : no_accumulators;
 
-    uint8_t one_byte{};
     uintmax_t counter{};
-    while (!file.eof()) {
+    if (restored_bytes) {
+        *restored_bytes = 0;
+    }
 
-        if (interrupt_all_) {
-            return std::vector<double>{};
+    // continue from the saved counts, restoring accumulators into the copy, 
+    // so that mismatched state does not spoil them
+    auto restore = [&](const byte_histogram& saved_counts, uintmax_t offset, const std::string& accumulators_state) {
+        AccumulatorSet restored = checkpoint_accumulators.clone_empty(0);
+        std::istringstream state(accumulators_state);
+        if (!restored.load(state)) {
+            return;
+        }
+        checkpoint_accumulators = std::move(restored);
+        counts = saved_counts;
+        counter = offset;
+        if (restored_bytes) {
+            *restored_bytes = offset;
         }
+    };
+
+    std::string state_path = IncrementalState::sidecar_path(file_path);
+    if (incremental_) {
+        // file should have only grown: the last counted block is the same
+        IncrementalState saved;
+        uint64_t tail_hash{};
+        if (saved.load(state_path) 
+            && saved.file_size <= fs::file_size(file_path)
+            && read_block_hash(file, saved.file_size, saved.tail_size, read_buffer, sizeof(read_buffer), tail_hash)
+            && saved.tail_hash == tail_hash) {
+            restore(saved.counts, saved.file_size, saved.accumulators_state);
+        }
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(counter));
+    }
 
-        file.read(reinterpret_cast<uint8_t*>(&one_byte), sizeof(uint8_t));
-        if (callback_) {
-            callback_(++counter);
+    // read-only or full disk costs only the ability to resume, not the counted result
+    auto save_sidecar = [this](const std::function<void()>& save) {
+        try {
+            save();
+        }
+        catch (const std::exception& e) {
+            if (sidecar_error_callback_) {
+                sidecar_error_callback_(e.what());
+            }
         }
-        ++bytes_distribution[one_byte];
+    };
+
+    uintmax_t next_checkpoint{};
+    ScanCheckpoint checkpoint;
+    std::string checkpoint_path = ScanCheckpoint::sidecar_path(file_path);
+
+    if (checkpoint_interval_) {
+        checkpoint.file_size = fs::file_size(file_path);
+        checkpoint.last_write_time = static_cast<int64_t>(fs::last_write_time(file_path));
+
+        ScanCheckpoint saved;
+        if (resume_ && saved.load(checkpoint_path) 
+            && saved.file_size == checkpoint.file_size 
+            && saved.last_write_time == checkpoint.last_write_time
+            && saved.offset <= saved.file_size
+            && saved.offset > counter) {
+            restore(saved.counts, saved.offset, saved.accumulators_state);
+            file.seekg(static_cast<std::streamoff>(counter));
+        }
+        next_checkpoint = counter + checkpoint_interval_;
     }
 
-    for (size_t i = 0; i != 256; ++i) {
-        if (interrupt_all_) {
-            return std::vector<double>{};
+    auto save_checkpoint = [&]() {
+        checkpoint.offset = counter;
+        checkpoint.counts = counts;
+        std::ostringstream state;
+        checkpoint_accumulators.save(state);
+        checkpoint.accumulators_state = state.str();
+        save_sidecar([&] { checkpoint.save(checkpoint_path); });
+    };
+
+    while (file) {
+
+        if (is_stopped()) {
+            if (checkpoint_interval_) {
+                save_checkpoint();
+            }
+            return false;
         }
 
-        bytes_frequencies[i] = static_cast<double>(bytes_distribution[i]) / file_size;
+        file.read(read_buffer, MAX_BUFFER_SIZE);
+        size_t block_size = static_cast<size_t>(file.gcount());
+        if (0 == block_size) {
+            break;
+        }
+
+        count_bytes(read_buffer, block_size, counts);
+        if (accumulators) {
+            accumulators->update(read_buffer, block_size);
+        }
+
+        counter += block_size;
+        if (callback_) {
+            callback_(counter);
+        }
+
+        if (checkpoint_interval_ && counter >= next_checkpoint) {
+            save_checkpoint();
+            next_checkpoint = counter + checkpoint_interval_;
+        }
+    }
+
+    if (checkpoint_interval_) {
+        boost::system::error_code error;
+        fs::remove(checkpoint_path, error);
     }
 
-    return std::move(bytes_frequencies);
+    if (incremental_) {
+        IncrementalState state;
+        state.file_size = counter;
+        state.tail_size = std::min<uintmax_t>(counter, IncrementalState::MAX_TAIL_SIZE);
+        state.counts = counts;
+        std::ostringstream accumulators_state;
+        checkpoint_accumulators.save(accumulators_state);
+        state.accumulators_state = accumulators_state.str();
+        if (read_block_hash(file, counter, state.tail_size, read_buffer, sizeof(read_buffer), state.tail_hash)) {
+            save_sidecar([&] { state.save(state_path); });
+        }
+    }
+    return true;
 }
 
-std::vector<double> ShannonEncryptionChecker::read_stream_probabilities(const uint8_t* sequence_start, size_t sequence_size) const
+bool ShannonEncryptionChecker::read_file_blocks(const std::string& file_path, 
+    const std::function<void(const uint8_t*, size_t)>& consume, uintmax_t max_size) const
 {
-    if (0 == sequence_size) {
-        return std::move(std::vector<double>(256));
-    }
+    uint8_t read_buffer[MAX_BUFFER_SIZE];
 
-    std::vector<size_t> bytes_distribution(256);
-    std::vector<double> bytes_frequencies(256);
+    std::basic_ifstream<uint8_t, std::char_traits<uint8_t>> file;
+    file.rdbuf()->pubsetbuf(nullptr, 0);
+    file.open(file_path, std::ios::in | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open file " + file_path);
+    }
 
     uintmax_t counter{};
-    for (size_t i = 0; i < sequence_size; ++i) {
-        if (interrupt_all_) {
-            return std::vector<double>{};
+    while (file && counter < max_size) {
+
+        if (is_stopped()) {
+            return false;
+        }
+
+        file.read(read_buffer, static_cast<std::streamsize>(std::min<uintmax_t>(MAX_BUFFER_SIZE, max_size - counter)));
+        size_t block_size = static_cast<size_t>(file.gcount());
+        if (0 == block_size) {
+            break;
+        }
+
+        consume(read_buffer, block_size);
+
+        counter += block_size;
+        if (callback_) {
+            callback_(counter);
+        }
+    }
+    return true;
+}
+
+bool ShannonEncryptionChecker::read_stream_counts(const uint8_t* sequence_start, size_t sequence_size,
+    byte_histogram& counts, AccumulatorSet* accumulators) const
+{
+    // count by blocks to check for interrupt and report progress
+    for (size_t offset = 0; offset < sequence_size; offset += MAX_BUFFER_SIZE) {
+
+        if (is_stopped()) {
+            return false;
+        }
+
+        size_t block_size = std::min(MAX_BUFFER_SIZE, sequence_size - offset);
+        count_bytes(sequence_start + offset, block_size, counts);
+        if (accumulators) {
+            accumulators->update(sequence_start + offset, block_size);
         }
 
         if (callback_) {
-            callback_(++counter);
+            callback_(offset + block_size);
         }
+    }
+    return true;
+}
+
+double entropy::histogram_entropy(const byte_histogram& counts)
+{
+    uintmax_t total = histogram_total(counts);
+    if (0 == total) {
+        return 0.;
+    }
+
+    double entropy{};
+    for (uintmax_t count : counts) {
+        if (0 == count) continue;
+        double probability = static_cast<double>(count) / total;
+        entropy += probability * log2(probability);
+    }
+    // not -entropy: single-valued data should give 0.0, not -0.0
+    return 0. - entropy;
+}
+
+double entropy::renyi_entropy(const byte_histogram& counts, double order)
+{
+    uintmax_t total = histogram_total(counts);
+    if (0 == total) {
+        return 0.;
+    }
+    if (1. == order) {
+        return histogram_entropy(counts);
+    }
 
-        ++bytes_distribution[sequence_start[i]];
+    if (std::isinf(order)) {
+        uintmax_t max_count = *std::max_element(counts.begin(), counts.end());
+        return 0. - log2(static_cast<double>(max_count) / total);
     }
 
-    for (size_t i = 0; i != 256; ++i) {
-        if (interrupt_all_) {
-            return std::vector<double>{};
+    double sum{};
+    for (uintmax_t count : counts) {
+        if (0 == count) continue;
+        double probability = static_cast<double>(count) / total;
+        // order 2 is the most requested one, avoid pow() for it
+        sum += 2. == order ? probability * probability : pow(probability, order);
+    }
+    return 0. == sum ? 0. : log2(sum) / (1. - order);
+}
+
+double entropy::min_entropy(const byte_histogram& counts)
+{
+    return renyi_entropy(counts, std::numeric_limits<double>::infinity());
+}
+
+double entropy::collision_entropy(const byte_histogram& counts)
+{
+    return renyi_entropy(counts, 2.);
+}
+
+EntropyMeasure EntropyMeasure::parse(const std::string& measure)
+{
+    if (measure == "shannon") {
+        return EntropyMeasure{ "shannon_entropy", 1. };
+    }
+    if (measure == "min") {
+        return EntropyMeasure{ "min_entropy", std::numeric_limits<double>::infinity() };
+    }
+    if (measure == "collision") {
+        return EntropyMeasure{ "collision_entropy", 2. };
+    }
+    if (measure == "hartley") {
+        return EntropyMeasure{ "hartley_entropy", 0. };
+    }
+
+    const std::string renyi_prefix = "renyi:";
+    if (measure.compare(0, renyi_prefix.size(), renyi_prefix) == 0) {
+        std::string order_string = measure.substr(renyi_prefix.size());
+        size_t parsed{};
+        double order{};
+        try {
+            order = std::stod(order_string, &parsed);
+        }
+        catch (const std::exception&) {
+            parsed = 0;
         }
+        if (0 == parsed || parsed != order_string.size() || !(order >= 0.)) {
+            throw std::invalid_argument("Invalid Renyi entropy order " + order_string);
+        }
+        return EntropyMeasure{ "renyi_entropy(" + order_string + ")", order };
+    }
+    throw std::invalid_argument("Unknown entropy measure " + measure);
+}
 
-        bytes_frequencies[i] = static_cast<double>(bytes_distribution[i]) / sequence_size;
+std::vector<EntropyMeasure> EntropyMeasure::parse_list(const std::string& measures)
+{
+    std::vector<EntropyMeasure> result;
+    std::istringstream list(measures);
+    std::string measure;
+    while (std::getline(list, measure, ',')) {
+        if (!measure.empty()) {
+            result.push_back(parse(measure));
+        }
     }
+    return result;
+}
 
-    return std::move(bytes_frequencies);
+accumulator_results entropy::entropy_measures(const byte_histogram& counts, const std::vector<EntropyMeasure>& measures)
+{
+    accumulator_results results;
+    results.reserve(measures.size());
+    for (const EntropyMeasure& measure : measures) {
+        results.emplace_back(measure.name, renyi_entropy(counts, measure.order));
+    }
+    return results;
 }
 
 double ShannonEncryptionChecker::estimated_epsilon(size_t sample_size) const
@@ -0,0 +1,112 @@
+#include <entropy/worker_pool.h>
+
+using namespace entropy;
+
+namespace {
+
+thread_local size_t current_worker_index = WorkerPool::NOT_WORKER;
+
+} // namespace
+
+WorkerPool::WorkerPool(size_t workers_count, size_t queue_limit, const NumaTopology& topology)
+    : topology_(topology)
+    , queue_limit_(queue_limit ? queue_limit : 1)
+{
+    if (0 == workers_count) {
+        workers_count = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    }
+    workers_count_ = workers_count;
+
+    workers_.reserve(workers_count);
+    for (size_t i = 0; i != workers_count; ++i) {
+        workers_.emplace_back(&WorkerPool::work, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    shutdown();
+}
+
+bool WorkerPool::try_submit(task_t task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_ || tasks_.size() >= queue_limit_) {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    task_ready_.notify_one();
+    return true;
+}
+
+bool WorkerPool::submit(task_t task)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        room_ready_.wait(lock, [this] { return stopped_ || tasks_.size() < queue_limit_; });
+        if (stopped_) {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    task_ready_.notify_one();
+    return true;
+}
+
+void WorkerPool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_ && workers_.empty()) {
+            return;
+        }
+        stopped_ = true;
+    }
+    task_ready_.notify_all();
+    room_ready_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+size_t WorkerPool::queued() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+size_t WorkerPool::worker_index()
+{
+    return current_worker_index;
+}
+
+void WorkerPool::work(size_t index)
+{
+    current_worker_index = index;
+    if (topology_.nodes_count() > 1) {
+        // memory the worker allocates is then placed on its node (first touch)
+        topology_.pin_current_thread(worker_node(index));
+    }
+
+    for (;;) {
+        task_t task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_ready_.wait(lock, [this] { return stopped_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                // stopped and drained
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        room_ready_.notify_one();
+        task();
+    }
+}
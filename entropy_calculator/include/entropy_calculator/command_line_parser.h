@@ -37,6 +37,18 @@ public:
         return _from_file;
     }
 
+    const std::string& read_from_dir() const {
+        return _from_dir;
+    }
+
+    size_t aggregate_depth() const {
+        return _aggregate_depth;
+    }
+
+    int pid() const {
+        return _pid;
+    }
+
     const std::string& random_distribution() const {
         return _random_distribution;
     }
@@ -53,6 +65,62 @@ public:
         return _sequence_size;
     }
 
+    bool is_randomness_tests() const {
+        return _randomness_tests;
+    }
+
+    const std::string& measures() const {
+        return _measures;
+    }
+
+    bool is_chunks() const {
+        return _chunks;
+    }
+
+    size_t chunk_size() const {
+        return _chunk_size;
+    }
+
+    bool is_elf() const {
+        return _elf;
+    }
+
+    bool is_incremental() const {
+        return _incremental;
+    }
+
+    size_t checkpoint_interval() const {
+        return _checkpoint_interval;
+    }
+
+    bool is_resume() const {
+        return _resume;
+    }
+
+    const std::string& daemon_socket() const {
+        return _daemon_socket;
+    }
+
+    const std::string& watch_dir() const {
+        return _watch_dir;
+    }
+
+    size_t debounce() const {
+        return _debounce;
+    }
+
+    size_t fast_check_size() const {
+        return _fast_check_size;
+    }
+
+    size_t workers_count() const {
+        return _workers_count;
+    }
+
+    size_t queue_limit() const {
+        return _queue_limit;
+    }
+
 private:
 
     /// Show help
@@ -64,6 +132,15 @@ private:
     /// Read file
     std::string _from_file;
 
+    /// Scan directory tree
+    std::string _from_dir;
+
+    /// Directory subtrees depth in the aggregated report
+    size_t _aggregate_depth = 0;
+
+    /// Scan memory of the live process
+    int _pid = 0;
+
     /// Mean
     double _mean = 0.;
 
@@ -73,6 +150,48 @@ private:
     /// Generates sequence size
     size_t _sequence_size = 0;
 
+    /// Calculate randomness tests battery in the same pass
+    bool _randomness_tests = false;
+
+    /// Comma-separated entropy measures of the Renyi family
+    std::string _measures;
+
+    /// Report entropy per content-defined chunk
+    bool _chunks = false;
+
+    /// Average content-defined chunk size
+    size_t _chunk_size = 0;
+
+    /// Report entropy per section and segment of the ELF executable
+    bool _elf = false;
+
+    /// Count only the tail appended since the previous file scan
+    bool _incremental = false;
+
+    /// Megabytes between checkpoints of the file scan
+    size_t _checkpoint_interval = 0;
+
+    /// Continue the file scan from the checkpoint
+    bool _resume = false;
+
+    /// Listen on the Unix domain socket
+    std::string _daemon_socket;
+
+    /// Re-evaluate files of the tree as they are written
+    std::string _watch_dir;
+
+    /// Milliseconds without writes before the watched file is evaluated
+    size_t _debounce = 0;
+
+    /// Kilobytes of the watched file start in the fast check
+    size_t _fast_check_size = 0;
+
+    /// Scanning threads, 0 means hardware concurrency
+    size_t _workers_count = 0;
+
+    /// Scans waiting for a free worker
+    size_t _queue_limit = 0;
+
     /// Generate sequence from random generator with provided distribution
     std::string _random_distribution;
 
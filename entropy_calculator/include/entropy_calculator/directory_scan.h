@@ -0,0 +1,31 @@
+#pragma once
+#include <entropy/entropy_aggregator.h>
+#include <iosfwd>
+#include <string>
+
+// The header contains batch scan of the directory tree with aggregated report
+
+namespace entropy {
+
+/// @brief Batch scan settings
+struct DirectoryScanOptions {
+
+    /// Scanning threads, 0 means hardware concurrency
+    size_t workers_count = 0;
+
+    /// Subtrees up to this depth below the root are reported
+    size_t directory_depth = 1;
+
+    /// Max groups of every kind, the rest are reported as one group
+    size_t max_groups = 1024;
+};
+
+/// @brief Scan all regular files of the tree in parallel, aggregating results by thread shards
+/// @return aggregated results of all successfully scanned files
+/// @throw std::runtime_error if the root could not be opened
+EntropyAggregator scan_directory(const std::string& root, const DirectoryScanOptions& options, uintmax_t& errors_count);
+
+/// @brief Print the aggregated report as tables per extension, directory and size class
+void print_aggregated_report(const EntropyAggregator& aggregator, std::ostream& out);
+
+} // namespace entropy
@@ -0,0 +1,48 @@
+#pragma once
+#include <entropy/byte_histogram.h>
+#include <entropy/elf_image.h>
+#include <entropy/worker_pool.h>
+#include <string>
+#include <vector>
+
+// The header contains section-aware entropy scan of ELF executables
+// File is memory-mapped once, headers are parsed in place and all sections, segments
+// and the whole file are scanned in parallel over the same mapping with no copying
+
+namespace entropy {
+
+/// @brief Entropy of the single section or segment
+struct RegionEntropy {
+
+    /// Copy of the region name, region.name itself is cleared as the file is unmapped after the scan
+    std::string name;
+    ElfRegion region;
+    byte_histogram counts{};
+    double entropy{};
+};
+
+/// @brief Per-section and per-segment results of the executable
+struct ExecutableEntropy {
+    bool is_64bit{};
+    uint16_t machine{};
+
+    std::vector<RegionEntropy> sections;
+    std::vector<RegionEntropy> segments;
+
+    /// Whole file
+    uintmax_t file_size{};
+    byte_histogram counts{};
+    double entropy{};
+};
+
+/// @brief Map the ELF file and calculate entropy of every section, segment and the whole file
+/// Regions are split into ranges scanned in parallel, range histograms are merged per region
+/// @param workers_count: scanning threads, 0 means hardware concurrency
+/// @throw std::runtime_error if the file is not a valid ELF image
+ExecutableEntropy scan_executable(const std::string& file_path, size_t workers_count);
+
+/// @brief Same scan on the pool shared by scans of several files, returns when ranges of this file are counted
+/// @throw std::runtime_error if the file is not a valid ELF image
+ExecutableEntropy scan_executable(const std::string& file_path, WorkerPool& pool);
+
+} // namespace entropy
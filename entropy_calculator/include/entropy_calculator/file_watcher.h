@@ -0,0 +1,136 @@
+#pragma once
+#include <entropy/shannon_entropy.h>
+#include <entropy/worker_pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+// The header contains continuous watch of the directory tree (Linux only)
+// Files are re-evaluated after inotify close-write events: bursts of events are debounced,
+// the changed file gets a fast check of its first blocks and is fully scanned only
+// if the fast check estimates it as encrypted
+
+namespace entropy {
+
+/// @brief Watch settings
+struct WatchOptions {
+
+    /// Root of the watched tree, subdirectories created later are watched too
+    std::string root;
+
+    /// Scanning threads, 0 means hardware concurrency
+    size_t workers_count = 0;
+
+    /// Files waiting for a free worker, the next due files wait in the pending set
+    size_t queue_limit = 64;
+
+    /// Changed files waiting for the debounce or a free worker, the next changes are dropped
+    size_t max_pending = 64 * 1024;
+
+    /// File is evaluated once it has not been written for this time
+    std::chrono::milliseconds debounce{ 500 };
+
+    /// Size of the fast check from the start of the file
+    uintmax_t fast_check_size = 512 * 1024;
+
+    /// Entropy of the smaller random sample stays below 8 - epsilon, the fast check never escalates
+    static constexpr uintmax_t MIN_FAST_CHECK_SIZE = 256 * 1024;
+};
+
+/// @brief Counters of the watch session
+struct WatchStatistics {
+    std::atomic<uintmax_t> events{};
+    std::atomic<uintmax_t> fast_checks{};
+    std::atomic<uintmax_t> full_scans{};
+    std::atomic<uintmax_t> encrypted{};
+    std::atomic<uintmax_t> errors{};
+
+    /// Changes lost: kernel event queue overflows and pending set overflows
+    std::atomic<uintmax_t> kernel_overflows{};
+    std::atomic<uintmax_t> dropped{};
+};
+
+/// @brief Re-evaluate entropy of files of the tree as they are written
+class FileWatcher {
+public:
+
+    /// @param out: every evaluation is reported here as a tab-separated line
+    /// @throw std::invalid_argument if the fast check size is below MIN_FAST_CHECK_SIZE
+    FileWatcher(const WatchOptions& options, std::ostream& out);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /// @brief Watch and evaluate until stop is requested
+    /// @throw std::runtime_error if inotify could not be initialized or the root could not be watched
+    void run();
+
+    /// @brief Stop watching, async-signal-safe
+    static void request_stop();
+
+    const WatchStatistics& statistics() const {
+        return statistics_;
+    }
+
+private:
+
+    using clock = std::chrono::steady_clock;
+
+    /// Watch the directory and all its subdirectories
+    /// @param touch_files: evaluate files already there, for directories created or moved into the tree
+    void add_watches(const std::string& directory, bool touch_files);
+
+    /// Read and handle all available inotify events
+    void read_events();
+
+    /// Remember the changed file, restarting its debounce interval
+    void touch(const std::string& file_path);
+
+    /// Queue files which were not written for the debounce interval
+    /// Files stay pending while the queue is full or the file is being evaluated
+    void dispatch_due();
+
+    /// Fast check of the first blocks, escalated to the full scan if needed
+    void evaluate(const std::string& file_path);
+
+    void report(const char* kind, double entropy, const std::string& description,
+        uintmax_t scanned_bytes, const std::string& file_path);
+
+    WatchOptions options_;
+    std::ostream& out_;
+    std::mutex out_mutex_;
+
+    ShannonEncryptionChecker shannon_;
+    WatchStatistics statistics_;
+
+    int inotify_fd_ = -1;
+
+    /// Watch descriptor to the watched directory
+    std::unordered_map<int, std::string> watches_;
+
+    /// Changed file to the time it becomes due
+    std::map<std::string, clock::time_point> pending_;
+
+    /// Files being evaluated by workers
+    std::mutex in_progress_mutex_;
+    std::set<std::string> in_progress_;
+
+    /// Destroyed first, so that tasks finish while members are alive
+    std::unique_ptr<WorkerPool> pool_;
+
+    /// Stop of the watcher, cleared when run() returns
+    static std::atomic<bool> stop_requested_;
+
+    /// Watcher is stopping or the process is interrupted, partial results are dropped
+    static bool is_stopped();
+};
+
+} // namespace entropy
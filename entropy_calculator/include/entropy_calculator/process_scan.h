@@ -0,0 +1,57 @@
+#pragma once
+#include <entropy/byte_histogram.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// The header contains entropy scan of the live process memory (Linux only)
+// Memory is copied with process_vm_readv(), the target process is never stopped
+
+namespace entropy {
+
+/// @brief Single line of /proc/<pid>/maps
+struct MemoryMapping {
+    uintptr_t start{};
+    uintptr_t end{};
+
+    /// e.g. "r-xp"
+    std::string permissions;
+
+    /// Mapped file or pseudo-path like [heap], empty for anonymous mappings
+    std::string path;
+
+    uintmax_t size() const {
+        return end - start;
+    }
+
+    bool is_readable() const {
+        return !permissions.empty() && 'r' == permissions[0];
+    }
+};
+
+/// @brief Entropy of the single mapping
+struct MappingEntropy {
+    MemoryMapping mapping;
+    byte_histogram counts{};
+
+    /// Pages which could not be read (guard pages, unmapped meanwhile)
+    uintmax_t unreadable_bytes{};
+
+    double entropy{};
+};
+
+/// @brief Parse /proc/<pid>/maps
+/// @throw std::runtime_error if the process does not exist or is not accessible
+std::vector<MemoryMapping> read_process_mappings(pid_t pid);
+
+/// Scanning threads if not set: the scanned process usually serves production load,
+/// so memory is read by a couple of threads instead of taking all cores from it
+constexpr size_t DEFAULT_PROCESS_SCAN_WORKERS = 2;
+
+/// @brief Calculate entropy of every readable mapping of the process
+/// Mappings are split into ranges scanned in parallel, range histograms are merged per mapping
+/// @param workers_count: scanning threads, 0 means DEFAULT_PROCESS_SCAN_WORKERS
+std::vector<MappingEntropy> scan_process_memory(pid_t pid, size_t workers_count);
+
+} // namespace entropy
@@ -0,0 +1,138 @@
+#pragma once
+#include <entropy/shannon_entropy.h>
+#include <entropy/worker_pool.h>
+#include <entropy_calculator/scan_result.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+// The header contains long-running scan daemon, listening on a Unix domain socket
+// Protocol is line-based, every request is answered with one result:
+//   PATH <json|binary> <file path>\n
+//   BUFFER <json|binary> <size>\n<size bytes>
+//   STATS\n - JSON with latency histograms and counters
+
+namespace entropy {
+
+/// @brief Daemon settings
+struct DaemonOptions {
+
+    /// Unix domain socket path, removed and created on start
+    std::string socket_path;
+
+    /// Scanning threads, 0 means hardware concurrency
+    size_t workers_count = 0;
+
+    /// Scans waiting for a free worker, the next one is refused as overloaded
+    size_t queue_limit = 64;
+
+    /// Simultaneously served clients
+    size_t max_connections = 256;
+
+    /// Max size of the BUFFER request
+    size_t max_buffer_size = 64 * 1024 * 1024;
+
+    /// Calculate randomness tests battery
+    bool randomness_tests = false;
+};
+
+/// @brief Lock-free latency histogram with quarter-of-power-of-two microsecond buckets
+class LatencyHistogram {
+public:
+
+    void add(std::chrono::microseconds latency);
+
+    /// @brief Upper bound of the bucket containing the percentile, in microseconds
+    /// @param percentile: value in range (0, 100]
+    uintmax_t percentile(double percentile) const;
+
+    /// @brief JSON object with count, mean, max, percentiles and non-empty buckets
+    std::string to_json() const;
+
+private:
+
+    static constexpr size_t BUCKETS_PER_POWER = 4;
+    static constexpr size_t BUCKETS_COUNT = 40 * BUCKETS_PER_POWER;
+
+    static size_t bucket_index(uintmax_t microseconds);
+    static uintmax_t bucket_upper_bound(size_t index);
+
+    std::array<std::atomic<uintmax_t>, BUCKETS_COUNT> buckets_{};
+    std::atomic<uintmax_t> count_{};
+    std::atomic<uintmax_t> total_microseconds_{};
+    std::atomic<uintmax_t> max_microseconds_{};
+};
+
+/// @brief Serve scan requests on a Unix domain socket, avoiding per-request process startup
+class ScanDaemon {
+public:
+
+    explicit ScanDaemon(const DaemonOptions& options);
+    ~ScanDaemon();
+
+    ScanDaemon(const ScanDaemon&) = delete;
+    ScanDaemon& operator=(const ScanDaemon&) = delete;
+
+    /// @brief Listen and serve until stop is requested
+    /// @throw std::runtime_error if the socket could not be created
+    void run();
+
+    /// @brief Stop serving, async-signal-safe
+    static void request_stop();
+
+private:
+
+    /// Request being scanned, waited by all identical requests
+    struct InFlight {
+        std::shared_future<ScanResult> result;
+
+        /// Buffer contents for BUFFER requests, hash collision check
+        std::shared_ptr<const std::string> buffer;
+    };
+
+    /// Serve one client until it disconnects
+    void serve_connection(int connection_fd);
+
+    /// Coalesce identical request or schedule the new one on the pool
+    ScanResult execute(const std::string& key, std::shared_ptr<const std::string> buffer,
+        std::function<ScanResult()> scan);
+
+    ScanResult scan_file(const std::string& file_path) const;
+    ScanResult scan_buffer(const std::string& buffer) const;
+
+    /// Fill common fields from the calculated histogram
+    void fill_result(ScanResult& result, double entropy, const byte_histogram& counts,
+        const AccumulatorSet& accumulators) const;
+
+    std::string stats_json() const;
+
+    DaemonOptions options_;
+    ShannonEncryptionChecker shannon_;
+    std::unique_ptr<WorkerPool> pool_;
+
+    std::mutex in_flight_mutex_;
+    std::unordered_map<std::string, InFlight> in_flight_;
+
+    /// Open client sockets, shut down on stop to unblock readers
+    std::mutex connections_mutex_;
+    std::condition_variable connections_done_;
+    std::set<int> connections_;
+
+    LatencyHistogram path_latency_;
+    LatencyHistogram buffer_latency_;
+    std::atomic<uintmax_t> coalesced_{};
+    std::atomic<uintmax_t> rejected_{};
+    std::atomic<uintmax_t> refused_connections_{};
+
+    static std::atomic<bool> stop_requested_;
+};
+
+} // namespace entropy
@@ -0,0 +1,54 @@
+#pragma once
+#include <entropy/block_accumulators.h>
+#include <cstdint>
+#include <string>
+
+// The header contains machine-readable scan results, used by the daemon mode
+
+namespace entropy {
+
+/// @brief Result of a single file or buffer scan
+struct ScanResult {
+
+    /// File path, or empty for buffers
+    std::string name;
+
+    /// Error message, all other fields are meaningless if not empty
+    std::string error;
+
+    uintmax_t size{};
+    double entropy{};
+    std::string estimation;
+    uintmax_t min_compressed_size{};
+
+    /// Randomness tests, if requested
+    accumulator_results accumulators;
+};
+
+/// @brief Output formats of the scan result
+enum class ResultFormat {
+    Json,
+    Binary
+};
+
+/// @brief Parse format name [json|binary]
+/// @throw std::invalid_argument on unknown format
+ResultFormat parse_result_format(const std::string& format_name);
+
+/// @brief Quote and escape string as JSON string literal
+std::string json_string(const std::string& value);
+
+/// @brief Single-line JSON object, terminated with '\n'
+std::string to_json(const ScanResult& result);
+
+/// @brief Little-endian binary record:
+/// u32 record size (without this field), u32 status (0 ok, 1 error),
+/// u64 size, f64 entropy, u64 min compressed size, u32 estimation length, estimation,
+/// u32 accumulators count, for each {u32 name length, name, f64 value},
+/// u32 name length, name, u32 error length, error
+std::string to_binary(const ScanResult& result);
+
+/// @brief Serialize in the requested format
+std::string format_result(const ScanResult& result, ResultFormat format);
+
+} // namespace entropy
@@ -18,12 +18,39 @@ void CommandLineParams::read_params(int argc, char* argv[])
         ("help,h", "Print usage")
         ("version,v", "Print version")
         ("from-file,f", po::value<string>(&_from_file), "Get a file as an information source (default option)")
+        ("from-dir,F", po::value<string>(&_from_dir), 
+            "Scan all files of the directory tree, report statistics per extension, directory and size class")
+        ("aggregate-depth", po::value<size_t>(&_aggregate_depth)->default_value(1),
+            "Depth of directory subtrees in the report (only with --from-dir)")
+        ("pid,p", po::value<int>(&_pid), "Scan memory of the live process, entropy per mapping (Linux only)")
         ("random-distribution,r", po::value<string>(&_random_distribution),
             "Get a random distribution as information source [linear|normal]")
         ("sequence-size,s", po::value<size_t>(&_sequence_size),
             "Size of the generated sequence (only if --random-distribution selected)")
         ("mean,m", po::value<double>(&_mean)->default_value(0.), "Mean for distribution (only for normal)")
         ("std-dev,d", po::value<double>(&_stddev)->default_value(1.0), "Standard deviation for distribution (only for normal)")
+        ("randomness-tests,t", "Also calculate chi-square, arithmetic mean, Monte Carlo Pi and serial correlation")
+        ("measures", po::value<string>(&_measures),
+            "Also calculate entropies of the Renyi family from the same histogram, comma-separated list of "
+            "shannon, min, collision, hartley, renyi:<order>")
+        ("chunks", "Report entropy per content-defined chunk and deduplication ratio of the file")
+        ("chunk-size", po::value<size_t>(&_chunk_size)->default_value(8192), 
+            "Average content-defined chunk size (only with --chunks)")
+        ("elf,e", "Report entropy per section and segment of the ELF executable")
+        ("checkpoint-interval,c", po::value<size_t>(&_checkpoint_interval)->default_value(0),
+            "Save file scan state every N megabytes and on interrupt, 0 to disable (1024 with --resume)")
+        ("resume", "Continue file scan from the saved checkpoint")
+        ("incremental,i", "Keep the file scan result and count only bytes appended since the previous scan (logs, journals)")
+        ("daemon,D", po::value<string>(&_daemon_socket), "Serve scan requests on the Unix domain socket")
+        ("watch,W", po::value<string>(&_watch_dir), 
+            "Re-evaluate files of the directory tree as they are written, report encrypted ones (Linux only)")
+        ("debounce", po::value<size_t>(&_debounce)->default_value(500),
+            "Milliseconds without writes before the file is evaluated (only with --watch)")
+        ("fast-check-size", po::value<size_t>(&_fast_check_size)->default_value(512),
+            "Kilobytes of the file start checked first, at least 256, the whole file is scanned if they look encrypted (only with --watch)")
+        ("workers,w", po::value<size_t>(&_workers_count)->default_value(0), "Scanning threads, 0 for hardware concurrency (2 with --pid, not to load the scanned process host)")
+        ("queue-limit,q", po::value<size_t>(&_queue_limit)->default_value(64),
+            "Scans waiting for a free worker, the next ones are refused or delayed (only with --daemon or --watch)")
         ;
 
     // command line params processing
@@ -33,14 +60,25 @@ void CommandLineParams::read_params(int argc, char* argv[])
 
     set_flag(cmd_variables_map, _help, "help");
     set_flag(cmd_variables_map, _version, "version");
+    set_flag(cmd_variables_map, _randomness_tests, "randomness-tests");
+    set_flag(cmd_variables_map, _resume, "resume");
+    set_flag(cmd_variables_map, _chunks, "chunks");
+    set_flag(cmd_variables_map, _elf, "elf");
+    set_flag(cmd_variables_map, _incremental, "incremental");
 
     // do not check debug flags!
-    std::list<bool> mutually_exclusives = { _help, _version, !_from_file.empty(), !_random_distribution.empty() };
+    std::list<bool> mutually_exclusives = { _help, _version, !_from_file.empty(), !_random_distribution.empty(),
+        !_from_dir.empty(), _pid != 0,
+        !_daemon_socket.empty(), !_watch_dir.empty() };
     size_t options_count = std::count(mutually_exclusives.begin(), mutually_exclusives.end(), true);
     if (options_count > 1) {
         throw std::logic_error("Incompatible command line parameters set, use only one");
     }
 
+    if (_chunks && _elf) {
+        throw std::logic_error("Chunks and ELF sections could not be reported together");
+    }
+
     std::list<bool> must_be_together = { !_random_distribution.empty(), _sequence_size ? true : false };
     options_count = std::count(must_be_together.begin(), must_be_together.end(), true);
     if ((options_count) && (options_count != 2)) {
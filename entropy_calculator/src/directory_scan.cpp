@@ -0,0 +1,144 @@
+#include <entropy_calculator/directory_scan.h>
+#include <entropy/scan_checkpoint.h>
+#include <entropy/shannon_entropy.h>
+#include <entropy/worker_pool.h>
+
+#include <boost/filesystem.hpp>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace entropy;
+namespace fs = boost::filesystem;
+
+namespace {
+
+void print_groups(const char* title, const EntropyAggregator::groups_t& groups, std::ostream& out)
+{
+    out << '\n' << title << '\n';
+    out << std::left << std::setw(24) << "Group" << std::right
+        << std::setw(12) << "Files" << std::setw(16) << "Bytes" << std::setw(10) << "Entropy"
+        << std::setw(10) << "Mean" << std::setw(10) << "p10" << std::setw(10) << "p50"
+        << std::setw(10) << "p90" << std::setw(10) << "p99" << '\n';
+
+    for (const auto& group : groups) {
+        const GroupStatistics& statistics = group.second;
+        out << std::left << std::setw(24) << group.first << std::right
+            << std::setw(12) << statistics.files_count
+            << std::setw(16) << histogram_total(statistics.counts)
+            << std::fixed << std::setprecision(4)
+            << std::setw(10) << histogram_entropy(statistics.counts)
+            << std::setw(10) << statistics.entropy.mean()
+            << std::setw(10) << statistics.entropy.quantile(0.1)
+            << std::setw(10) << statistics.entropy.quantile(0.5)
+            << std::setw(10) << statistics.entropy.quantile(0.9)
+            << std::setw(10) << statistics.entropy.quantile(0.99)
+            << std::defaultfloat << '\n';
+    }
+}
+
+} // namespace
+
+EntropyAggregator entropy::scan_directory(const std::string& root, const DirectoryScanOptions& options, uintmax_t& errors_count)
+{
+    ShannonEncryptionChecker shannon;
+    std::atomic<uintmax_t> errors{};
+    std::vector<EntropyAggregator> shards;
+    std::vector<size_t> shard_nodes;
+    NumaTopology topology = NumaTopology::detect();
+    {
+        // queue is short: directory walk waits for workers instead of holding millions of paths
+        // on NUMA machine workers are pinned to nodes, so groups they add are allocated node-local
+        WorkerPool pool(options.workers_count, 1024, topology);
+        for (size_t i = 0; i != pool.workers_count(); ++i) {
+            shards.emplace_back(options.directory_depth, options.max_groups);
+            shard_nodes.push_back(pool.worker_node(i));
+        }
+
+        std::string root_prefix = fs::path(root).generic_string();
+        if (!root_prefix.empty() && root_prefix.back() != '/') {
+            root_prefix += '/';
+        }
+
+        boost::system::error_code error;
+        fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, error), end;
+        if (error) {
+            throw std::runtime_error("Unable to scan directory " + root + ": " + error.message());
+        }
+        for (; it != end && !ShannonEncryptionChecker::is_interrupted(); it.increment(error)) {
+            if (error) {
+                ++errors;
+                continue;
+            }
+            if (!fs::is_regular_file(it->symlink_status())) {
+                continue;
+            }
+
+            // state of previous scans, not the scanned data
+            std::string file_path = it->path().generic_string();
+            if (is_scan_sidecar(file_path)) {
+                continue;
+            }
+            std::string relative_path = file_path.compare(0, root_prefix.size(), root_prefix) == 0
+                ? file_path.substr(root_prefix.size()) : file_path;
+
+            pool.submit([&shannon, &shards, &errors, file_path, relative_path] {
+                try {
+                    AccumulatorSet no_accumulators;
+                    byte_histogram counts{};
+                    double entropy = shannon.get_file_entropy(file_path, no_accumulators, counts);
+                    if (!ShannonEncryptionChecker::is_interrupted()) {
+                        // every worker owns its shard, no locking
+                        shards[WorkerPool::worker_index()].add(relative_path, entropy, counts);
+                    }
+                }
+                catch (const std::exception&) {
+                    ++errors;
+                }
+            });
+        }
+    }
+
+    // shards are merged on their own node first, only one aggregator per node crosses the interconnect
+    std::vector<EntropyAggregator> node_reports(topology.nodes_count(), EntropyAggregator(options.directory_depth, options.max_groups));
+    if (node_reports.size() > 1) {
+        std::vector<std::thread> mergers;
+        for (size_t node = 0; node != node_reports.size(); ++node) {
+            mergers.emplace_back([&, node] {
+                topology.pin_current_thread(node);
+                for (size_t i = 0; i != shards.size(); ++i) {
+                    if (shard_nodes[i] == node) {
+                        node_reports[node].merge(shards[i]);
+                    }
+                }
+            });
+        }
+        for (std::thread& merger : mergers) {
+            merger.join();
+        }
+        shards.swap(node_reports);
+    }
+
+    EntropyAggregator report(options.directory_depth, options.max_groups);
+    for (const auto& shard : shards) {
+        report.merge(shard);
+    }
+    errors_count = errors.load();
+    return report;
+}
+
+void entropy::print_aggregated_report(const EntropyAggregator& aggregator, std::ostream& out)
+{
+    const GroupStatistics& total = aggregator.total();
+    out << "Files = " << total.files_count << '\n';
+    out << "Bytes = " << histogram_total(total.counts) << '\n';
+    out << "Entropy of all bytes = " << std::setprecision(16) << histogram_entropy(total.counts) << '\n';
+    out << "Median file entropy = " << total.entropy.quantile(0.5) << '\n';
+
+    print_groups("Per extension:", aggregator.extensions(), out);
+    print_groups("Per directory:", aggregator.directories(), out);
+    print_groups("Per size class:", aggregator.size_classes(), out);
+}
@@ -0,0 +1,131 @@
+#include <entropy_calculator/executable_scan.h>
+#include <entropy/shannon_entropy.h>
+#include <entropy/worker_pool.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+
+using namespace entropy;
+namespace fs = boost::filesystem;
+namespace ipc = boost::interprocess;
+
+namespace {
+
+/// Bytes counted between interrupt checks
+constexpr uint64_t COUNT_BATCH_SIZE = 1024 * 1024;
+
+/// Large regions are split into ranges of this size to be scanned in parallel
+constexpr uint64_t RANGE_SIZE = 4 * 1024 * 1024;
+
+/// Part of the region scanned by one task
+struct RangeResult {
+    byte_histogram* target{};
+    uint64_t offset{};
+    uint64_t end{};
+    byte_histogram counts{};
+};
+
+/// Split the region of the mapped file into ranges
+void add_ranges(byte_histogram& target, uint64_t offset, uint64_t size, std::vector<RangeResult>& ranges)
+{
+    for (uint64_t start = offset; start < offset + size; start += RANGE_SIZE) {
+        RangeResult range;
+        range.target = &target;
+        range.offset = start;
+        range.end = std::min(offset + size, start + RANGE_SIZE);
+        ranges.push_back(range);
+    }
+}
+
+std::vector<RegionEntropy> make_results(const std::vector<ElfRegion>& regions)
+{
+    std::vector<RegionEntropy> results(regions.size());
+    for (size_t i = 0; i != regions.size(); ++i) {
+        results[i].name = regions[i].name;
+        results[i].region = regions[i];
+        results[i].region.name = "";
+    }
+    return results;
+}
+
+} // namespace
+
+ExecutableEntropy entropy::scan_executable(const std::string& file_path, size_t workers_count)
+{
+    WorkerPool pool(workers_count, 1024);
+    return scan_executable(file_path, pool);
+}
+
+ExecutableEntropy entropy::scan_executable(const std::string& file_path, WorkerPool& pool)
+{
+    ExecutableEntropy executable;
+    executable.file_size = fs::file_size(file_path);
+    if (0 == executable.file_size) {
+        throw std::runtime_error("Not an ELF image: " + file_path + " is empty");
+    }
+
+    // read-only mapping, pages are shared with the page cache
+    ipc::file_mapping file(file_path.c_str(), ipc::read_only);
+    ipc::mapped_region mapping(file, ipc::read_only);
+    mapping.advise(ipc::mapped_region::advice_willneed);
+    const uint8_t* image = static_cast<const uint8_t*>(mapping.get_address());
+    size_t image_size = mapping.get_size();
+
+    ElfImage elf(image, image_size);
+    executable.is_64bit = elf.is_64bit();
+    executable.machine = elf.machine();
+    executable.sections = make_results(elf.sections());
+    executable.segments = make_results(elf.segments());
+
+    // result vectors are not resized anymore, ranges may refer to their histograms
+    std::vector<RangeResult> ranges;
+    for (RegionEntropy& section : executable.sections) {
+        add_ranges(section.counts, section.region.offset, section.region.size, ranges);
+    }
+    for (RegionEntropy& segment : executable.segments) {
+        add_ranges(segment.counts, segment.region.offset, segment.region.size, ranges);
+    }
+    add_ranges(executable.counts, 0, image_size, ranges);
+
+    // pool outlives the scan, so completion of this file's ranges is counted down here
+    std::mutex done_mutex;
+    std::condition_variable done;
+    size_t remaining = ranges.size();
+
+    for (RangeResult& range : ranges) {
+        pool.submit([image, &range, &done_mutex, &done, &remaining] {
+            for (uint64_t offset = range.offset; offset < range.end; offset += COUNT_BATCH_SIZE) {
+                if (ShannonEncryptionChecker::is_interrupted()) {
+                    break;
+                }
+                uint64_t batch_size = std::min(COUNT_BATCH_SIZE, range.end - offset);
+                count_bytes(image + offset, static_cast<size_t>(batch_size), range.counts);
+            }
+            std::lock_guard<std::mutex> lock(done_mutex);
+            if (0 == --remaining) {
+                done.notify_one();
+            }
+        });
+    }
+    {
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done.wait(lock, [&remaining] { return 0 == remaining; });
+    }
+
+    for (const RangeResult& range : ranges) {
+        merge_histograms(*range.target, range.counts);
+    }
+    for (RegionEntropy& section : executable.sections) {
+        section.entropy = histogram_entropy(section.counts);
+    }
+    for (RegionEntropy& segment : executable.segments) {
+        segment.entropy = histogram_entropy(segment.counts);
+    }
+    executable.entropy = histogram_entropy(executable.counts);
+    return executable;
+}
@@ -0,0 +1,283 @@
+#include <entropy_calculator/file_watcher.h>
+
+#include <boost/filesystem.hpp>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using namespace entropy;
+namespace fs = boost::filesystem;
+
+std::atomic<bool> FileWatcher::stop_requested_{ false };
+
+namespace {
+
+/// Files are reported written or moved in, directories are watched as they appear
+constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR | IN_DONT_FOLLOW;
+
+/// Max wait for events, so that the stop flag is checked
+constexpr int POLL_TIMEOUT_MS = 200;
+
+/// Wait for events while some files are waiting for the debounce
+constexpr int PENDING_POLL_TIMEOUT_MS = 50;
+
+} // namespace
+
+FileWatcher::FileWatcher(const WatchOptions& options, std::ostream& out)
+    : options_(options)
+    , out_(out)
+    , pool_(std::make_unique<WorkerPool>(options.workers_count, options.queue_limit))
+{
+    if (options_.fast_check_size < WatchOptions::MIN_FAST_CHECK_SIZE) {
+        throw std::invalid_argument("Fast check size should be at least " 
+            + std::to_string(WatchOptions::MIN_FAST_CHECK_SIZE / 1024) + " KB, the smaller one never estimates random data as encrypted");
+    }
+    // evaluation in progress stops with the watcher, other scans of the process are not interrupted
+    shannon_.set_stop_flag(&stop_requested_);
+}
+
+FileWatcher::~FileWatcher()
+{
+    pool_->shutdown();
+    if (inotify_fd_ >= 0) {
+        ::close(inotify_fd_);
+    }
+}
+
+void FileWatcher::request_stop()
+{
+    stop_requested_.store(true);
+}
+
+bool FileWatcher::is_stopped()
+{
+    // global interrupt is left to signal handlers of the application, but honoured
+    return stop_requested_.load() || ShannonEncryptionChecker::is_interrupted();
+}
+
+void FileWatcher::run()
+{
+    inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        throw std::runtime_error(std::string("Unable to initialize inotify: ") + std::strerror(errno));
+    }
+
+    add_watches(options_.root, false);
+    if (watches_.empty()) {
+        throw std::runtime_error("Unable to watch " + options_.root);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(out_mutex_);
+        out_ << "Watching " << options_.root << " (" << watches_.size() << " directories) with "
+            << pool_->workers_count() << " workers\n";
+        out_ << "Check\tEntropy\tEstimation\tScanned\tPath\n" << std::flush;
+    }
+
+    while (!stop_requested_.load()) {
+
+        pollfd events_poll{ inotify_fd_, POLLIN, 0 };
+        int timeout = pending_.empty() ? POLL_TIMEOUT_MS : PENDING_POLL_TIMEOUT_MS;
+        if (::poll(&events_poll, 1, timeout) > 0) {
+            read_events();
+        }
+        dispatch_due();
+    }
+
+    // queued evaluations see the stop flag and return at once
+    pool_->shutdown();
+
+    // the next watcher of the process starts afresh
+    stop_requested_.store(false);
+}
+
+void FileWatcher::add_watches(const std::string& directory, bool touch_files)
+{
+    auto add_watch = [this](const std::string& path) {
+        int watch = ::inotify_add_watch(inotify_fd_, path.c_str(), WATCH_MASK);
+        if (watch < 0) {
+            // e.g. ENOSPC if max_user_watches is exhausted
+            ++statistics_.errors;
+            return;
+        }
+        watches_[watch] = path;
+    };
+
+    add_watch(directory);
+
+    boost::system::error_code error;
+    fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, error), end;
+    for (; it != end; it.increment(error)) {
+        if (error) {
+            ++statistics_.errors;
+            continue;
+        }
+        fs::file_status status = it->symlink_status();
+        if (fs::is_directory(status)) {
+            add_watch(it->path().string());
+        }
+        else if (touch_files && fs::is_regular_file(status)) {
+            touch(it->path().string());
+        }
+    }
+}
+
+void FileWatcher::read_events()
+{
+    alignas(inotify_event) char buffer[64 * 1024];
+
+    for (;;) {
+        ssize_t length = ::read(inotify_fd_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // EAGAIN, all events are read
+            return;
+        }
+
+        for (char* position = buffer; position < buffer + length; ) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(position);
+            position += sizeof(inotify_event) + event->len;
+            ++statistics_.events;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                ++statistics_.kernel_overflows;
+                continue;
+            }
+
+            auto watch = watches_.find(event->wd);
+            if (watch == watches_.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                // directory is removed
+                watches_.erase(watch);
+                continue;
+            }
+            if (0 == event->len) {
+                continue;
+            }
+
+            std::string path = watch->second + '/' + event->name;
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    add_watches(path, true);
+                }
+            }
+            else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                touch(path);
+            }
+        }
+    }
+}
+
+void FileWatcher::touch(const std::string& file_path)
+{
+    auto deadline = clock::now() + options_.debounce;
+    auto pending = pending_.find(file_path);
+    if (pending != pending_.end()) {
+        pending->second = deadline;
+        return;
+    }
+    if (pending_.size() >= options_.max_pending) {
+        ++statistics_.dropped;
+        return;
+    }
+    pending_.emplace(file_path, deadline);
+}
+
+void FileWatcher::dispatch_due()
+{
+    auto now = clock::now();
+    for (auto it = pending_.begin(); it != pending_.end(); ) {
+        if (it->second > now) {
+            ++it;
+            continue;
+        }
+
+        std::string file_path = it->first;
+        {
+            // file written during its evaluation waits for the next round
+            std::lock_guard<std::mutex> lock(in_progress_mutex_);
+            if (!in_progress_.insert(file_path).second) {
+                ++it;
+                continue;
+            }
+        }
+
+        bool queued = pool_->try_submit([this, file_path] {
+            if (!is_stopped()) {
+                evaluate(file_path);
+            }
+            std::lock_guard<std::mutex> lock(in_progress_mutex_);
+            in_progress_.erase(file_path);
+        });
+        if (!queued) {
+            // backpressure: workers are behind, the rest due files stay pending
+            std::lock_guard<std::mutex> lock(in_progress_mutex_);
+            in_progress_.erase(file_path);
+            return;
+        }
+        it = pending_.erase(it);
+    }
+}
+
+void FileWatcher::evaluate(const std::string& file_path)
+{
+    try {
+        byte_histogram counts{};
+        double entropy = shannon_.get_file_head_entropy(file_path, options_.fast_check_size, counts);
+        uintmax_t scanned = histogram_total(counts);
+        if (is_stopped() || 0 == scanned) {
+            return;
+        }
+        ++statistics_.fast_checks;
+
+        const char* kind = "Fast";
+        ShannonEncryptionChecker::InformationEntropyEstimation estimation =
+            shannon_.information_entropy_estimation(entropy, static_cast<size_t>(scanned));
+
+        std::string description = shannon_.get_information_description(estimation);
+
+        // only the suspicious file is read to the end
+        if (ShannonEncryptionChecker::Encrypted == estimation && scanned >= options_.fast_check_size) {
+            AccumulatorSet no_accumulators;
+            entropy = shannon_.get_file_entropy(file_path, no_accumulators, counts);
+            scanned = histogram_total(counts);
+            if (is_stopped()) {
+                return;
+            }
+            ++statistics_.full_scans;
+            kind = "Full";
+
+            // the full scan does not clear the file flagged by the fast check:
+            // epsilon shrinks with the size, so random data past 1 MB could miss it and look Binary
+            ShannonEncryptionChecker::InformationEntropyEstimation full_estimation =
+                shannon_.information_entropy_estimation(entropy, static_cast<size_t>(scanned));
+            if (full_estimation != estimation) {
+                description += " (whole file " + shannon_.get_information_description(full_estimation) + ")";
+            }
+        }
+
+        if (ShannonEncryptionChecker::Encrypted == estimation) {
+            ++statistics_.encrypted;
+        }
+        report(kind, entropy, description, scanned, file_path);
+    }
+    catch (const std::exception&) {
+        // usually the file is removed or replaced meanwhile
+        ++statistics_.errors;
+    }
+}
+
+void FileWatcher::report(const char* kind, double entropy, const std::string& description,
+    uintmax_t scanned_bytes, const std::string& file_path)
+{
+    std::lock_guard<std::mutex> lock(out_mutex_);
+    out_ << kind << '\t' << std::fixed << std::setprecision(6) << entropy << std::defaultfloat << '\t'
+        << description << '\t' << scanned_bytes << '\t' << file_path << '\n' << std::flush;
+}
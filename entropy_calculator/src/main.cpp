@@ -1,6 +1,8 @@
 #include <entropy/shannon_entropy.h>
 #include <entropy_calculator/random_distributions.h>
 #include <entropy_calculator/command_line_parser.h>
+#include <entropy_calculator/directory_scan.h>
+#include <entropy_calculator/executable_scan.h>
 
 #include <boost/filesystem.hpp>
 #include <boost/progress.hpp>
@@ -12,6 +14,14 @@
 
 #if defined(_WIN32) || defined(_WIN64)
 #include <Windows.h>
+#else
+#include <entropy_calculator/scan_daemon.h>
+#include <csignal>
+#endif
+
+#if defined(__linux__)
+#include <entropy_calculator/file_watcher.h>
+#include <entropy_calculator/process_scan.h>
 #endif
 
 using namespace std;
@@ -27,6 +37,7 @@ struct ProgressCallback
 
     void init(unsigned long op_count)
     {
+        count = 0;
         progress_bar = std::make_unique<boost::progress_display>(
             static_cast<unsigned long>(op_count), 
             std::cout, 
@@ -35,12 +46,13 @@ struct ProgressCallback
             "Complete:");
     }
 
-    void operator()()
+    void operator()(uintmax_t iteration)
     {
-        ++(*progress_bar);
+        (*progress_bar) += static_cast<unsigned long>(iteration - count);
+        count = iteration;
     }
 
-    uintmax_t count;
+    uintmax_t count{};
     std::unique_ptr<boost::progress_display> progress_bar;
 };
 
@@ -54,7 +66,12 @@ static ProgressCallback& get_progress()
 void progress_callback(uintmax_t iteration)
 {
     auto& progress = get_progress();
-    progress();
+    progress(iteration);
+}
+
+void sidecar_error_callback(const std::string& message)
+{
+    std::cerr << "\nWarning: " << message << ", scan continues without saving its state\n";
 }
 
 static CommandLineParams& get_params()
@@ -73,6 +90,25 @@ BOOL WINAPI ctrl_handler(DWORD ctrl_type)
     return TRUE;
 }
 
+#else
+
+void stop_handler(int signal)
+{
+    ScanDaemon::request_stop();
+}
+
+void interrupt_handler(int signal)
+{
+    ShannonEncryptionChecker::interrupt();
+}
+
+#if defined(__linux__)
+void watch_stop_handler(int signal)
+{
+    FileWatcher::request_stop();
+}
+#endif
+
 #endif
 
 void usage_exit()
@@ -88,6 +124,21 @@ void print_version_exit()
     exit(EXIT_SUCCESS);
 }
 
+void print_randomness_tests(const accumulator_results& results)
+{
+    for (const auto& result : results) {
+        std::cout << result.first << " = " << std::setprecision(16) << result.second << '\n';
+    }
+}
+
+void print_entropy_measures(const byte_histogram& counts)
+{
+    const std::string& measures = get_params().measures();
+    if (!measures.empty()) {
+        print_randomness_tests(entropy_measures(counts, EntropyMeasure::parse_list(measures)));
+    }
+}
+
 void calculate_file_entropy(const std::string& filename) 
 {
     std::cout << "Please patience, entropy calculation on big files takes a while...\n";
@@ -99,8 +150,41 @@ void calculate_file_entropy(const std::string& filename)
 
     get_progress().init(file_size);
     shannon.set_callback(&progress_callback);
+    shannon.set_sidecar_error_callback(&sidecar_error_callback);
+
+    // interrupted scan saves checkpoint, so Ctrl+C should not kill the process
+    const CommandLineParams& params = get_params();
+    uintmax_t checkpoint_interval = params.checkpoint_interval();
+    if (params.is_resume() && 0 == checkpoint_interval) {
+        checkpoint_interval = 1024;
+    }
+    if (checkpoint_interval) {
+        shannon.set_checkpoint(checkpoint_interval * 1024 * 1024, params.is_resume());
+#if defined(_WIN32) || defined(_WIN64)
+        SetConsoleCtrlHandler(ctrl_handler, TRUE);
+#else
+        std::signal(SIGINT, interrupt_handler);
+        std::signal(SIGTERM, interrupt_handler);
+#endif
+    }
+
+    shannon.set_incremental(params.is_incremental());
 
-    double entropy = shannon.get_file_entropy(filename);
+    AccumulatorSet accumulators;
+    if (get_params().is_randomness_tests()) {
+        accumulators = AccumulatorSet::randomness_battery();
+    }
+    byte_histogram counts{};
+    uintmax_t restored_bytes{};
+    double entropy = shannon.get_file_entropy(filename, accumulators, counts, &restored_bytes);
+    if (ShannonEncryptionChecker::is_interrupted()) {
+        std::cout << "\nInterrupted after " << histogram_total(counts) << " bytes";
+        if (checkpoint_interval) {
+            std::cout << ", continue with --resume";
+        }
+        std::cout << '\n';
+        return;
+    }
     size_t min_compressed = shannon.min_compressed_size(entropy, file_size);
     ShannonEncryptionChecker::InformationEntropyEstimation entropy_estimation = 
         shannon.information_entropy_estimation(entropy, file_size);
@@ -110,17 +194,185 @@ void calculate_file_entropy(const std::string& filename)
     auto diff = end - start;
     std::cout << "File name: " << filename << '\n';
     std::cout << "File size = " << file_size << " bytes\n";
+    if (params.is_incremental() || params.is_resume()) {
+        std::cout << "Restored from the previous scan = " << restored_bytes << " bytes\n";
+    }
     std::cout << "Entropy = " << std::setprecision(16) << entropy << '\n';
     std::cout << "Time = " << static_cast<int>(chrono::duration<double, milli>(diff).count()) << " ms" << '\n';
     std::cout << "Information entropy estimation: " << description << '\n';
     std::cout << "Min possible file size assuming max theoretical compression efficiency: " << min_compressed << " bytes\n";
+    print_entropy_measures(counts);
+    print_randomness_tests(accumulators.report(counts));
+}
+
+void calculate_file_chunks_entropy(const std::string& filename)
+{
+    auto start = chrono::steady_clock::now();
+
+    ShannonEncryptionChecker shannon;
+    AccumulatorSet accumulators;
+    if (get_params().is_randomness_tests()) {
+        accumulators = AccumulatorSet::randomness_battery();
+    }
+
+    std::cout << "Offset\tSize\tHash\tEntropy\tDuplicate\n";
+    ContentChunker chunker(ChunkingOptions::from_average(get_params().chunk_size()), [](const ChunkRecord& chunk) {
+        std::cout << chunk.offset << '\t' << chunk.size << '\t' 
+            << std::hex << std::setw(16) << std::setfill('0') << chunk.hash << std::dec << std::setfill(' ') << '\t'
+            << std::fixed << std::setprecision(6) << chunk.entropy << std::defaultfloat << '\t'
+            << (chunk.duplicate ? "yes" : "no") << '\n';
+    });
+
+    double entropy = shannon.get_file_chunks_entropy(filename, chunker, accumulators);
+    if (ShannonEncryptionChecker::is_interrupted()) {
+        return;
+    }
+    auto end = chrono::steady_clock::now();
+
+    const ChunkingSummary& summary = chunker.summary();
+    std::cout << "File name: " << filename << '\n';
+    std::cout << "File size = " << summary.total_bytes << " bytes\n";
+    std::cout << "Entropy = " << std::setprecision(16) << entropy << '\n';
+    std::cout << "Time = " << static_cast<int>(chrono::duration<double, milli>(end - start).count()) << " ms" << '\n';
+    std::cout << "Chunks = " << summary.chunks_count << ", unique = " << summary.unique_chunks_count << '\n';
+    std::cout << "Unique bytes = " << summary.unique_bytes << '\n';
+    std::cout << "Deduplication ratio = " << summary.dedup_ratio();
+    if (summary.dedup_estimated()) {
+        std::cout << " (at least, " << summary.unindexed_chunks_count << " chunks were not indexed)";
+    }
+    std::cout << '\n';
+    print_entropy_measures(summary.counts);
+    print_randomness_tests(accumulators.report(summary.counts));
+}
+
+void print_regions(const char* title, const std::vector<RegionEntropy>& regions, const ShannonEncryptionChecker& shannon)
+{
+    std::cout << title << "\tFlags\tOffset\tSize\tEntropy\tEstimation\n";
+    for (const RegionEntropy& region : regions) {
+        // regions without file bytes (.bss) have no estimation
+        std::string description = region.region.size
+            ? shannon.get_information_description(
+                shannon.information_entropy_estimation(region.entropy, static_cast<size_t>(region.region.size)))
+            : "-";
+        std::cout << region.name << '\t' << ElfImage::flags_description(region.region) << '\t'
+            << region.region.offset << '\t' << region.region.size << (region.region.truncated ? " (truncated)" : "") << '\t'
+            << std::fixed << std::setprecision(6) << region.entropy << std::defaultfloat << '\t'
+            << description << '\n';
+    }
+}
+
+void calculate_executable_entropy(const std::string& filename)
+{
+    auto start = chrono::steady_clock::now();
+
+#if defined(_WIN32) || defined(_WIN64)
+    SetConsoleCtrlHandler(ctrl_handler, TRUE);
+#else
+    std::signal(SIGINT, interrupt_handler);
+    std::signal(SIGTERM, interrupt_handler);
+#endif
+
+    ShannonEncryptionChecker shannon;
+    ExecutableEntropy executable = scan_executable(filename, get_params().workers_count());
+    auto end = chrono::steady_clock::now();
+
+    if (ShannonEncryptionChecker::is_interrupted()) {
+        std::cout << "Interrupted, the report covers only bytes counted so far\n";
+    }
+
+    print_regions("Section", executable.sections, shannon);
+    std::cout << '\n';
+    print_regions("Segment", executable.segments, shannon);
+    std::cout << '\n';
+
+    std::string description = shannon.get_information_description(
+        shannon.information_entropy_estimation(executable.entropy, static_cast<size_t>(executable.file_size)));
+    std::cout << "File name: " << filename << '\n';
+    std::cout << "ELF class = " << (executable.is_64bit ? 64 : 32) << ", machine = " << executable.machine << '\n';
+    std::cout << "File size = " << executable.file_size << " bytes\n";
+    std::cout << "Entropy = " << std::setprecision(16) << executable.entropy << '\n';
+    std::cout << "Time = " << static_cast<int>(chrono::duration<double, milli>(end - start).count()) << " ms" << '\n';
+    std::cout << "Information entropy estimation: " << description << '\n';
+}
+
+void calculate_directory_entropy(const std::string& directory)
+{
+    std::cout << "Please patience, scanning the whole tree takes a while...\n";
+    auto start = chrono::steady_clock::now();
+
+#if defined(_WIN32) || defined(_WIN64)
+    SetConsoleCtrlHandler(ctrl_handler, TRUE);
+#else
+    std::signal(SIGINT, interrupt_handler);
+    std::signal(SIGTERM, interrupt_handler);
+#endif
+
+    DirectoryScanOptions options;
+    options.workers_count = get_params().workers_count();
+    options.directory_depth = get_params().aggregate_depth();
+
+    uintmax_t errors_count{};
+    EntropyAggregator aggregator = scan_directory(directory, options, errors_count);
+    auto end = chrono::steady_clock::now();
+
+    if (ShannonEncryptionChecker::is_interrupted()) {
+        std::cout << "\nInterrupted, the report covers only files scanned so far\n";
+    }
+    std::cout << "Directory: " << directory << '\n';
+    std::cout << "Time = " << static_cast<int>(chrono::duration<double, milli>(end - start).count()) << " ms" << '\n';
+    std::cout << "Errors = " << errors_count << '\n';
+    print_aggregated_report(aggregator, std::cout);
+}
+
+void calculate_process_entropy(int pid)
+{
+#if defined(__linux__)
+    auto start = chrono::steady_clock::now();
+    std::signal(SIGINT, interrupt_handler);
+    std::signal(SIGTERM, interrupt_handler);
+
+    ShannonEncryptionChecker shannon;
+    std::vector<MappingEntropy> mappings = scan_process_memory(pid, get_params().workers_count());
+    auto end = chrono::steady_clock::now();
+
+    if (ShannonEncryptionChecker::is_interrupted()) {
+        std::cout << "\nInterrupted, the report covers only memory scanned so far\n";
+    }
+
+    byte_histogram total{};
+    std::cout << "Mapping\tPermissions\tSize\tUnreadable\tEntropy\tEstimation\tPath\n";
+    for (const MappingEntropy& mapping : mappings) {
+        uintmax_t scanned = histogram_total(mapping.counts);
+        merge_histograms(total, mapping.counts);
+
+        std::string description = scanned 
+            ? shannon.get_information_description(shannon.information_entropy_estimation(mapping.entropy, scanned)) 
+            : "-";
+        std::cout << std::hex << mapping.mapping.start << '-' << mapping.mapping.end << std::dec << '\t'
+            << mapping.mapping.permissions << '\t' << mapping.mapping.size() << '\t' << mapping.unreadable_bytes << '\t'
+            << std::fixed << std::setprecision(6) << mapping.entropy << std::defaultfloat << '\t'
+            << description << '\t' << mapping.mapping.path << '\n';
+    }
+
+    std::cout << "Process: " << pid << '\n';
+    std::cout << "Scanned bytes = " << histogram_total(total) << '\n';
+    std::cout << "Entropy = " << std::setprecision(16) << histogram_entropy(total) << '\n';
+    std::cout << "Time = " << static_cast<int>(chrono::duration<double, milli>(end - start).count()) << " ms" << '\n';
+#else
+    throw std::runtime_error("Process memory scan requires Linux process_vm_readv()");
+#endif
 }
 
 void calculate_sequence_entropy(const std::vector<uint8_t>& sequence)
 {
     std::cout << "Please patience, entropy calculation on big files takes a while...\n";
     ShannonEncryptionChecker shannon;
-    double entropy = shannon.get_sequence_entropy(&sequence[0], sequence.size());
+    AccumulatorSet accumulators;
+    if (get_params().is_randomness_tests()) {
+        accumulators = AccumulatorSet::randomness_battery();
+    }
+    byte_histogram counts{};
+    double entropy = shannon.get_sequence_entropy(sequence.data(), sequence.size(), accumulators, counts);
     size_t min_compressed = shannon.min_compressed_size(entropy, sequence.size());
     ShannonEncryptionChecker::InformationEntropyEstimation entropy_estimation = shannon.information_entropy_estimation(entropy, sequence.size());
     std::string description = shannon.get_information_description(entropy_estimation);
@@ -129,6 +381,56 @@ void calculate_sequence_entropy(const std::vector<uint8_t>& sequence)
     std::cout << "Entropy = " << std::setprecision(16) << entropy << '\n';
     std::cout << "Information entropy estimation: " << description << '\n';
     std::cout << "Min possible file size assuming max theoretical compression efficiency: " << min_compressed << " bytes\n";
+    print_entropy_measures(counts);
+    print_randomness_tests(accumulators.report(counts));
+}
+
+void run_daemon(const CommandLineParams& params)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    throw std::runtime_error("Daemon mode requires Unix domain sockets");
+#else
+    DaemonOptions options;
+    options.socket_path = params.daemon_socket();
+    options.workers_count = params.workers_count();
+    options.queue_limit = params.queue_limit();
+    options.randomness_tests = params.is_randomness_tests();
+
+    std::signal(SIGINT, stop_handler);
+    std::signal(SIGTERM, stop_handler);
+
+    ScanDaemon daemon(options);
+    daemon.run();
+#endif
+}
+
+void watch_directory(const CommandLineParams& params)
+{
+#if defined(__linux__)
+    WatchOptions options;
+    options.root = params.watch_dir();
+    options.workers_count = params.workers_count();
+    options.queue_limit = params.queue_limit();
+    options.debounce = std::chrono::milliseconds(params.debounce());
+    options.fast_check_size = static_cast<uintmax_t>(params.fast_check_size()) * 1024;
+
+    std::signal(SIGINT, watch_stop_handler);
+    std::signal(SIGTERM, watch_stop_handler);
+
+    FileWatcher watcher(options, std::cout);
+    watcher.run();
+
+    const WatchStatistics& statistics = watcher.statistics();
+    std::cout << "Events = " << statistics.events << '\n';
+    std::cout << "Fast checks = " << statistics.fast_checks << '\n';
+    std::cout << "Full scans = " << statistics.full_scans << '\n';
+    std::cout << "Encrypted = " << statistics.encrypted << '\n';
+    std::cout << "Errors = " << statistics.errors << '\n';
+    std::cout << "Dropped = " << statistics.dropped << '\n';
+    std::cout << "Kernel queue overflows = " << statistics.kernel_overflows << '\n';
+#else
+    throw std::runtime_error("Watch mode requires Linux inotify");
+#endif
 }
 
 int main(int argc, char* argv[]) {
@@ -151,6 +453,39 @@ int main(int argc, char* argv[]) {
             print_version_exit();
         }
 
+        // unknown measure should fail before the long scan, not after it
+        EntropyMeasure::parse_list(cmd_line_params.measures());
+
+        if (!cmd_line_params.daemon_socket().empty()) {
+            run_daemon(cmd_line_params);
+            return EXIT_SUCCESS;
+        }
+
+        if (!cmd_line_params.watch_dir().empty()) {
+            watch_directory(cmd_line_params);
+            return EXIT_SUCCESS;
+        }
+
+        if (cmd_line_params.pid()) {
+            calculate_process_entropy(cmd_line_params.pid());
+            return EXIT_SUCCESS;
+        }
+
+        if (!cmd_line_params.read_from_dir().empty()) {
+            calculate_directory_entropy(cmd_line_params.read_from_dir());
+            return EXIT_SUCCESS;
+        }
+
+        if (!cmd_line_params.read_from_file().empty() && cmd_line_params.is_elf()) {
+            calculate_executable_entropy(cmd_line_params.read_from_file());
+            return EXIT_SUCCESS;
+        }
+
+        if (!cmd_line_params.read_from_file().empty() && cmd_line_params.is_chunks()) {
+            calculate_file_chunks_entropy(cmd_line_params.read_from_file());
+            return EXIT_SUCCESS;
+        }
+
         if (!cmd_line_params.read_from_file().empty()) {
             calculate_file_entropy(cmd_line_params.read_from_file());
             return EXIT_SUCCESS;
@@ -0,0 +1,159 @@
+#include <entropy_calculator/process_scan.h>
+#include <entropy/shannon_entropy.h>
+#include <entropy/worker_pool.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace entropy;
+
+namespace {
+
+/// Bytes copied by a single process_vm_readv() call
+constexpr size_t READ_BATCH_SIZE = 1024 * 1024;
+
+/// Large mappings are split into ranges of this size to be scanned in parallel
+constexpr uintmax_t RANGE_SIZE = 64 * 1024 * 1024;
+
+/// Part of the mapping scanned by one task
+struct RangeResult {
+    size_t mapping_index{};
+    uintptr_t start{};
+    uintptr_t end{};
+    byte_histogram counts{};
+    uintmax_t unreadable_bytes{};
+};
+
+/// Copy the range batch by batch, unreadable pages are skipped
+void scan_range(pid_t pid, RangeResult& range, uint8_t* buffer)
+{
+    static const size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+
+    uintptr_t address = range.start;
+    while (address < range.end && !ShannonEncryptionChecker::is_interrupted()) {
+        size_t batch_size = static_cast<size_t>(std::min<uintmax_t>(READ_BATCH_SIZE, range.end - address));
+
+        iovec local{ buffer, batch_size };
+        iovec remote{ reinterpret_cast<void*>(address), batch_size };
+        ssize_t copied = ::process_vm_readv(pid, &local, 1, &remote, 1, 0);
+
+        if (copied > 0) {
+            count_bytes(buffer, static_cast<size_t>(copied), range.counts);
+            address += static_cast<size_t>(copied);
+            continue;
+        }
+        if (copied < 0 && (ESRCH == errno || EPERM == errno)) {
+            // process is gone or we are not allowed, the rest is unreadable
+            range.unreadable_bytes += range.end - address;
+            return;
+        }
+
+        // first page of the batch is not readable, skip it
+        size_t skipped = std::min<uintmax_t>(page_size - address % page_size, range.end - address);
+        range.unreadable_bytes += skipped;
+        address += skipped;
+    }
+}
+
+} // namespace
+
+std::vector<MemoryMapping> entropy::read_process_mappings(pid_t pid)
+{
+    std::string maps_path = "/proc/" + std::to_string(pid) + "/maps";
+    std::ifstream maps(maps_path);
+    if (!maps) {
+        throw std::runtime_error("Unable to read " + maps_path);
+    }
+
+    // address-range perms offset dev inode [path]
+    std::vector<MemoryMapping> mappings;
+    std::string line;
+    while (std::getline(maps, line)) {
+        std::istringstream fields(line);
+        std::string range;
+        std::string offset;
+        std::string device;
+        std::string inode;
+
+        MemoryMapping mapping;
+        if (!(fields >> range >> mapping.permissions >> offset >> device >> inode)) {
+            continue;
+        }
+        std::getline(fields >> std::ws, mapping.path);
+
+        size_t dash = range.find('-');
+        if (std::string::npos == dash) {
+            continue;
+        }
+        mapping.start = static_cast<uintptr_t>(std::stoull(range.substr(0, dash), nullptr, 16));
+        mapping.end = static_cast<uintptr_t>(std::stoull(range.substr(dash + 1), nullptr, 16));
+        mappings.push_back(std::move(mapping));
+    }
+    return mappings;
+}
+
+std::vector<MappingEntropy> entropy::scan_process_memory(pid_t pid, size_t workers_count)
+{
+    std::vector<MemoryMapping> mappings = read_process_mappings(pid);
+
+    // kernel pseudo-mappings could not be copied by process_vm_readv()
+    auto is_scanned = [](const MemoryMapping& mapping) {
+        return mapping.is_readable() && mapping.path != "[vvar]" && mapping.path != "[vsyscall]";
+    };
+
+    std::vector<RangeResult> ranges;
+    for (size_t i = 0; i != mappings.size(); ++i) {
+        if (!is_scanned(mappings[i])) {
+            continue;
+        }
+        for (uintptr_t start = mappings[i].start; start < mappings[i].end; start += RANGE_SIZE) {
+            RangeResult range;
+            range.mapping_index = i;
+            range.start = start;
+            range.end = static_cast<uintptr_t>(std::min<uintmax_t>(mappings[i].end, uintmax_t{ start } + RANGE_SIZE));
+            ranges.push_back(range);
+        }
+    }
+
+    {
+        WorkerPool pool(workers_count ? workers_count : DEFAULT_PROCESS_SCAN_WORKERS, ranges.size());
+        std::vector<std::unique_ptr<uint8_t[]>> buffers(pool.workers_count());
+        for (auto& buffer : buffers) {
+            buffer = std::make_unique<uint8_t[]>(READ_BATCH_SIZE);
+        }
+
+        // every task owns its range result and uses the buffer of its worker
+        for (RangeResult& range : ranges) {
+            pool.submit([pid, &range, &buffers] {
+                scan_range(pid, range, buffers[WorkerPool::worker_index()].get());
+            });
+        }
+
+        // buffers must outlive the running tasks
+        pool.shutdown();
+    }
+
+    std::vector<MappingEntropy> results(mappings.size());
+    for (size_t i = 0; i != mappings.size(); ++i) {
+        results[i].mapping = mappings[i];
+        if (!is_scanned(mappings[i])) {
+            results[i].unreadable_bytes = mappings[i].size();
+        }
+    }
+    for (const RangeResult& range : ranges) {
+        merge_histograms(results[range.mapping_index].counts, range.counts);
+        results[range.mapping_index].unreadable_bytes += range.unreadable_bytes;
+    }
+    for (MappingEntropy& result : results) {
+        result.entropy = histogram_entropy(result.counts);
+    }
+    return results;
+}
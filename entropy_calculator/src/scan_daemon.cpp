@@ -0,0 +1,440 @@
+#include <entropy_calculator/scan_daemon.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace entropy;
+
+std::atomic<bool> ScanDaemon::stop_requested_{ false };
+
+namespace {
+
+/// Buffered reader of the client socket
+class SocketReader {
+public:
+
+    explicit SocketReader(int fd) : fd_(fd) {}
+
+    /// Read line without '\n', false on disconnect
+    bool read_line(std::string& line, size_t max_size)
+    {
+        line.clear();
+        for (;;) {
+            auto end = std::find(buffer_.begin() + position_, buffer_.end(), '\n');
+            line.append(buffer_.begin() + position_, end);
+            if (end != buffer_.end()) {
+                position_ = (end - buffer_.begin()) + 1;
+                return true;
+            }
+            position_ = buffer_.size();
+            if (line.size() > max_size || !fill()) {
+                return false;
+            }
+        }
+    }
+
+    /// Read exactly size bytes, false on disconnect
+    bool read_exact(std::string& data, size_t size)
+    {
+        data.clear();
+        data.reserve(size);
+        while (data.size() < size) {
+            if (position_ == buffer_.size() && !fill()) {
+                return false;
+            }
+            size_t chunk = std::min(size - data.size(), buffer_.size() - position_);
+            data.append(buffer_.data() + position_, chunk);
+            position_ += chunk;
+        }
+        return true;
+    }
+
+private:
+
+    bool fill()
+    {
+        buffer_.resize(BUFFER_SIZE);
+        position_ = 0;
+        for (;;) {
+            ssize_t received = ::recv(fd_, &buffer_[0], BUFFER_SIZE, 0);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            buffer_.resize(received > 0 ? static_cast<size_t>(received) : 0);
+            return received > 0;
+        }
+    }
+
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    int fd_;
+    std::string buffer_;
+    size_t position_{};
+};
+
+bool send_all(int fd, const std::string& data)
+{
+    size_t sent_total = 0;
+    while (sent_total < data.size()) {
+        ssize_t sent = ::send(fd, data.data() + sent_total, data.size() - sent_total, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        sent_total += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+ScanResult error_result(const std::string& name, const std::string& error)
+{
+    ScanResult result;
+    result.name = name;
+    result.error = error;
+    return result;
+}
+
+} // namespace
+
+//
+// LatencyHistogram
+//
+
+size_t LatencyHistogram::bucket_index(uintmax_t microseconds)
+{
+    size_t index = static_cast<size_t>(std::log2(static_cast<double>(microseconds) + 1.) * BUCKETS_PER_POWER);
+    return std::min(index, BUCKETS_COUNT - 1);
+}
+
+uintmax_t LatencyHistogram::bucket_upper_bound(size_t index)
+{
+    return static_cast<uintmax_t>(std::ceil(std::exp2(static_cast<double>(index + 1) / BUCKETS_PER_POWER) - 1.));
+}
+
+void LatencyHistogram::add(std::chrono::microseconds latency)
+{
+    uintmax_t microseconds = static_cast<uintmax_t>(std::max<std::chrono::microseconds::rep>(latency.count(), 0));
+    buckets_[bucket_index(microseconds)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_microseconds_.fetch_add(microseconds, std::memory_order_relaxed);
+
+    uintmax_t max = max_microseconds_.load(std::memory_order_relaxed);
+    while (microseconds > max && !max_microseconds_.compare_exchange_weak(max, microseconds)) {
+    }
+}
+
+uintmax_t LatencyHistogram::percentile(double percentile) const
+{
+    uintmax_t count = count_.load(std::memory_order_relaxed);
+    if (0 == count) {
+        return 0;
+    }
+
+    uintmax_t rank = static_cast<uintmax_t>(std::ceil(count * percentile / 100.));
+    uintmax_t seen{};
+    for (size_t i = 0; i != BUCKETS_COUNT; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucket_upper_bound(i), max_microseconds_.load(std::memory_order_relaxed));
+        }
+    }
+    return max_microseconds_.load(std::memory_order_relaxed);
+}
+
+std::string LatencyHistogram::to_json() const
+{
+    uintmax_t count = count_.load(std::memory_order_relaxed);
+    std::ostringstream json;
+    json << "{\"count\":" << count
+        << ",\"mean_us\":" << (count ? total_microseconds_.load(std::memory_order_relaxed) / count : 0)
+        << ",\"max_us\":" << max_microseconds_.load(std::memory_order_relaxed)
+        << ",\"p50_us\":" << percentile(50.)
+        << ",\"p90_us\":" << percentile(90.)
+        << ",\"p99_us\":" << percentile(99.)
+        << ",\"p999_us\":" << percentile(99.9)
+        << ",\"buckets\":[";
+
+    bool first = true;
+    for (size_t i = 0; i != BUCKETS_COUNT; ++i) {
+        uintmax_t bucket = buckets_[i].load(std::memory_order_relaxed);
+        if (0 == bucket) {
+            continue;
+        }
+        json << (first ? "" : ",") << "{\"le_us\":" << bucket_upper_bound(i) << ",\"count\":" << bucket << "}";
+        first = false;
+    }
+    json << "]}";
+    return json.str();
+}
+
+//
+// ScanDaemon
+//
+
+ScanDaemon::ScanDaemon(const DaemonOptions& options)
+    : options_(options)
+    , pool_(std::make_unique<WorkerPool>(options.workers_count, options.queue_limit))
+{
+}
+
+ScanDaemon::~ScanDaemon()
+{
+    pool_->shutdown();
+}
+
+void ScanDaemon::request_stop()
+{
+    stop_requested_.store(true);
+}
+
+void ScanDaemon::run()
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (options_.socket_path.empty() || options_.socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Invalid socket path " + options_.socket_path);
+    }
+    std::strncpy(address.sun_path, options_.socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    int listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error(std::string("Unable to create socket: ") + std::strerror(errno));
+    }
+
+    ::unlink(options_.socket_path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(listen_fd, SOMAXCONN) < 0) {
+        std::string error = std::strerror(errno);
+        ::close(listen_fd);
+        throw std::runtime_error("Unable to listen on " + options_.socket_path + ": " + error);
+    }
+
+    std::cout << "Listening on " << options_.socket_path << " with " << pool_->workers_count() << " workers\n" << std::flush;
+
+    while (!stop_requested_.load()) {
+
+        // wake up periodically to check the stop flag
+        pollfd listen_poll{ listen_fd, POLLIN, 0 };
+        if (::poll(&listen_poll, 1, 200) <= 0) {
+            continue;
+        }
+
+        int connection_fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection_fd < 0) {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex_);
+            if (connections_.size() >= options_.max_connections) {
+                ++refused_connections_;
+                send_all(connection_fd, to_json(error_result("", "Too many connections")));
+                ::close(connection_fd);
+                continue;
+            }
+            connections_.insert(connection_fd);
+        }
+        std::thread(&ScanDaemon::serve_connection, this, connection_fd).detach();
+    }
+
+    ::close(listen_fd);
+    ::unlink(options_.socket_path.c_str());
+
+    // unblock clients waiting on read, requests being scanned are completed
+    std::unique_lock<std::mutex> lock(connections_mutex_);
+    for (int connection_fd : connections_) {
+        ::shutdown(connection_fd, SHUT_RD);
+    }
+    connections_done_.wait(lock, [this] { return connections_.empty(); });
+}
+
+void ScanDaemon::serve_connection(int connection_fd)
+{
+    SocketReader reader(connection_fd);
+    std::string line;
+
+    while (reader.read_line(line, 64 * 1024)) {
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::istringstream request(line);
+        std::string command;
+        std::string format_name;
+        request >> command >> format_name;
+
+        if (command == "STATS") {
+            if (!send_all(connection_fd, stats_json())) {
+                break;
+            }
+            continue;
+        }
+
+        ResultFormat format = ResultFormat::Json;
+        try {
+            format = parse_result_format(format_name);
+        }
+        catch (const std::exception& e) {
+            send_all(connection_fd, to_json(error_result("", e.what())));
+            continue;
+        }
+
+        ScanResult result;
+        LatencyHistogram* latency = nullptr;
+
+        if (command == "PATH") {
+            std::string file_path;
+            std::getline(request >> std::ws, file_path);
+
+            // file is identified by its modification time as well, changed files are not coalesced
+            struct stat file_stat {};
+            if (::stat(file_path.c_str(), &file_stat) < 0) {
+                result = error_result(file_path, std::strerror(errno));
+            }
+            else {
+                std::string key = "P" + std::to_string(file_stat.st_size) + ":"
+                    + std::to_string(file_stat.st_mtim.tv_sec) + "." + std::to_string(file_stat.st_mtim.tv_nsec)
+                    + ":" + file_path;
+                result = execute(key, nullptr, [this, file_path] { return scan_file(file_path); });
+            }
+            latency = &path_latency_;
+        }
+        else if (command == "BUFFER") {
+            size_t buffer_size{};
+            if (!(request >> buffer_size) || buffer_size > options_.max_buffer_size) {
+                // the rest of the stream could not be parsed anymore
+                send_all(connection_fd, format_result(error_result("", "Invalid buffer size"), format));
+                break;
+            }
+
+            auto buffer = std::make_shared<std::string>();
+            if (!reader.read_exact(*buffer, buffer_size)) {
+                break;
+            }
+            std::string key = "B" + std::to_string(std::hash<std::string>{}(*buffer)) + ":" + std::to_string(buffer_size);
+            result = execute(key, buffer, [this, buffer] { return scan_buffer(*buffer); });
+            latency = &buffer_latency_;
+        }
+        else {
+            result = error_result("", "Unknown command " + command);
+        }
+
+        if (!send_all(connection_fd, format_result(result, format))) {
+            break;
+        }
+        if (latency) {
+            latency->add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+        }
+    }
+
+    ::close(connection_fd);
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    connections_.erase(connection_fd);
+    connections_done_.notify_all();
+}
+
+ScanResult ScanDaemon::execute(const std::string& key, std::shared_ptr<const std::string> buffer,
+    std::function<ScanResult()> scan)
+{
+    auto promise = std::make_shared<std::promise<ScanResult>>();
+    std::shared_future<ScanResult> result = promise->get_future().share();
+    std::shared_future<ScanResult> running;
+    bool coalescing = true;
+    {
+        std::lock_guard<std::mutex> lock(in_flight_mutex_);
+        auto found = in_flight_.find(key);
+        if (found == in_flight_.end()) {
+            in_flight_.emplace(key, InFlight{ result, buffer });
+        }
+        else if (!buffer || *found->second.buffer == *buffer) {
+            running = found->second.result;
+        }
+        else {
+            // hash collision of different buffers, scan it without coalescing
+            coalescing = false;
+        }
+    }
+
+    if (running.valid()) {
+        ++coalesced_;
+        return running.get();
+    }
+
+    auto complete = [this, key, promise, coalescing](ScanResult scan_result) {
+        if (coalescing) {
+            std::lock_guard<std::mutex> lock(in_flight_mutex_);
+            in_flight_.erase(key);
+        }
+        promise->set_value(std::move(scan_result));
+    };
+
+    if (!pool_->try_submit([scan, complete] { complete(scan()); })) {
+        ++rejected_;
+        complete(error_result("", "Server is overloaded, try later"));
+    }
+    return result.get();
+}
+
+ScanResult ScanDaemon::scan_file(const std::string& file_path) const
+{
+    ScanResult result;
+    result.name = file_path;
+    try {
+        AccumulatorSet accumulators = options_.randomness_tests ? AccumulatorSet::randomness_battery() : AccumulatorSet{};
+        byte_histogram counts{};
+        double entropy = shannon_.get_file_entropy(file_path, accumulators, counts);
+        fill_result(result, entropy, counts, accumulators);
+    }
+    catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    return result;
+}
+
+ScanResult ScanDaemon::scan_buffer(const std::string& buffer) const
+{
+    ScanResult result;
+    AccumulatorSet accumulators = options_.randomness_tests ? AccumulatorSet::randomness_battery() : AccumulatorSet{};
+    byte_histogram counts{};
+    double entropy = shannon_.get_sequence_entropy(reinterpret_cast<const uint8_t*>(buffer.data()), buffer.size(),
+        accumulators, counts);
+    fill_result(result, entropy, counts, accumulators);
+    return result;
+}
+
+void ScanDaemon::fill_result(ScanResult& result, double entropy, const byte_histogram& counts,
+    const AccumulatorSet& accumulators) const
+{
+    result.size = histogram_total(counts);
+    result.entropy = entropy;
+    result.estimation = shannon_.get_information_description(
+        shannon_.information_entropy_estimation(entropy, static_cast<size_t>(result.size)));
+    result.min_compressed_size = shannon_.min_compressed_size(entropy, static_cast<size_t>(result.size));
+    result.accumulators = accumulators.report(counts);
+}
+
+std::string ScanDaemon::stats_json() const
+{
+    std::ostringstream json;
+    json << "{\"path_latency\":" << path_latency_.to_json()
+        << ",\"buffer_latency\":" << buffer_latency_.to_json()
+        << ",\"coalesced\":" << coalesced_.load()
+        << ",\"rejected\":" << rejected_.load()
+        << ",\"refused_connections\":" << refused_connections_.load()
+        << ",\"queued\":" << pool_->queued()
+        << ",\"workers\":" << pool_->workers_count()
+        << "}\n";
+    return json.str();
+}
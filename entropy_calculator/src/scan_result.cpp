@@ -0,0 +1,138 @@
+#include <entropy_calculator/scan_result.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+using namespace entropy;
+
+namespace {
+
+void put_u32(std::string& out, uint32_t value)
+{
+    for (int i = 0; i != 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void put_u64(std::string& out, uint64_t value)
+{
+    for (int i = 0; i != 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void put_f64(std::string& out, double value)
+{
+    uint64_t bits{};
+    static_assert(sizeof(bits) == sizeof(value), "IEEE 754 double expected");
+    std::memcpy(&bits, &value, sizeof(bits));
+    put_u64(out, bits);
+}
+
+void put_string(std::string& out, const std::string& value)
+{
+    put_u32(out, static_cast<uint32_t>(value.size()));
+    out += value;
+}
+
+/// JSON has no NaN and infinity
+std::string json_number(double value)
+{
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    std::ostringstream number;
+    number << std::setprecision(17) << value;
+    return number.str();
+}
+
+} // namespace
+
+ResultFormat entropy::parse_result_format(const std::string& format_name)
+{
+    if (format_name == "json") {
+        return ResultFormat::Json;
+    }
+    if (format_name == "binary") {
+        return ResultFormat::Binary;
+    }
+    throw std::invalid_argument("Unknown result format " + format_name);
+}
+
+std::string entropy::json_string(const std::string& value)
+{
+    std::string quoted;
+    quoted.reserve(value.size() + 2);
+    quoted.push_back('"');
+    for (char c : value) {
+        switch (c) {
+        case '"': quoted += "\\\""; break;
+        case '\\': quoted += "\\\\"; break;
+        case '\n': quoted += "\\n"; break;
+        case '\r': quoted += "\\r"; break;
+        case '\t': quoted += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                quoted += escaped;
+            }
+            else {
+                quoted.push_back(c);
+            }
+        }
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+std::string entropy::to_json(const ScanResult& result)
+{
+    std::string json = "{";
+    if (!result.name.empty()) {
+        json += "\"name\":" + json_string(result.name) + ",";
+    }
+    if (!result.error.empty()) {
+        json += "\"error\":" + json_string(result.error) + "}\n";
+        return json;
+    }
+
+    json += "\"size\":" + std::to_string(result.size);
+    json += ",\"entropy\":" + json_number(result.entropy);
+    json += ",\"estimation\":" + json_string(result.estimation);
+    json += ",\"min_compressed_size\":" + std::to_string(result.min_compressed_size);
+    for (const auto& accumulator : result.accumulators) {
+        json += "," + json_string(accumulator.first) + ":" + json_number(accumulator.second);
+    }
+    json += "}\n";
+    return json;
+}
+
+std::string entropy::to_binary(const ScanResult& result)
+{
+    std::string record;
+    put_u32(record, result.error.empty() ? 0 : 1);
+    put_u64(record, result.size);
+    put_f64(record, result.entropy);
+    put_u64(record, result.min_compressed_size);
+    put_string(record, result.estimation);
+    put_u32(record, static_cast<uint32_t>(result.accumulators.size()));
+    for (const auto& accumulator : result.accumulators) {
+        put_string(record, accumulator.first);
+        put_f64(record, accumulator.second);
+    }
+    put_string(record, result.name);
+    put_string(record, result.error);
+
+    std::string sized;
+    put_u32(sized, static_cast<uint32_t>(record.size()));
+    return sized + record;
+}
+
+std::string entropy::format_result(const ScanResult& result, ResultFormat format)
+{
+    return ResultFormat::Json == format ? to_json(result) : to_binary(result);
+}
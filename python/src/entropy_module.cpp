@@ -0,0 +1,600 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <entropy/shannon_entropy.h>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+// Python module "entropy" on top of the entropy library
+// Functions accept any contiguous buffer-protocol object (bytes, bytearray, memoryview, numpy arrays)
+// without copying, counting runs with the GIL released.
+// Histogram exports its counts as the buffer of 256 uint64 values, e.g. numpy.frombuffer(h, numpy.uint64)
+// While the buffer is exported the histogram could not be changed, like bytearray could not be resized
+
+using namespace entropy;
+
+static_assert(sizeof(uintmax_t) == sizeof(unsigned long long), "Histogram is exported as 'Q' buffer");
+
+namespace {
+
+/// Single checker, its constructor installs the uint8_t codecvt facet once
+ShannonEncryptionChecker& get_checker()
+{
+    static ShannonEncryptionChecker checker;
+    return checker;
+}
+
+/// Contiguous bytes of the buffer-protocol object, the object could not be resized while viewed
+class BufferView {
+public:
+
+    BufferView() = default;
+    BufferView(const BufferView&) = delete;
+    BufferView& operator=(const BufferView&) = delete;
+
+    ~BufferView() {
+        if (acquired_) {
+            PyBuffer_Release(&view_);
+        }
+    }
+
+    /// @return false with Python exception set
+    bool acquire(PyObject* object) {
+        if (PyObject_GetBuffer(object, &view_, PyBUF_SIMPLE) < 0) {
+            return false;
+        }
+        acquired_ = true;
+        return true;
+    }
+
+    const uint8_t* data() const {
+        return static_cast<const uint8_t*>(view_.buf);
+    }
+
+    size_t size() const {
+        return static_cast<size_t>(view_.len);
+    }
+
+private:
+    Py_buffer view_{};
+    bool acquired_ = false;
+};
+
+/// Counts are guarded by the mutex, as updates run without the GIL
+struct HistogramState {
+    std::mutex mutex;
+    byte_histogram counts{};
+
+    /// Exported buffers alive, counts are frozen while there are any
+    Py_ssize_t exports{};
+};
+
+const char* HISTOGRAM_EXPORTED_ERROR = "Histogram could not be changed while its buffer is exported";
+
+struct HistogramObject {
+    PyObject_HEAD
+    HistogramState* state;
+};
+
+/// Histogram and accumulators of the stream fed block by block
+struct StreamState {
+    std::mutex mutex;
+    byte_histogram counts{};
+    AccumulatorSet accumulators;
+};
+
+struct StreamObject {
+    PyObject_HEAD
+    StreamState* state;
+};
+
+PyTypeObject HistogramType = { PyVarObject_HEAD_INIT(nullptr, 0) };
+PyTypeObject StreamType = { PyVarObject_HEAD_INIT(nullptr, 0) };
+
+PyObject* results_dict(const accumulator_results& results)
+{
+    PyObject* dict = PyDict_New();
+    if (!dict) {
+        return nullptr;
+    }
+    for (const auto& result : results) {
+        PyObject* value = PyFloat_FromDouble(result.second);
+        if (!value || PyDict_SetItemString(dict, result.first.c_str(), value) < 0) {
+            Py_XDECREF(value);
+            Py_DECREF(dict);
+            return nullptr;
+        }
+        Py_DECREF(value);
+    }
+    return dict;
+}
+
+PyObject* new_histogram(const byte_histogram& counts)
+{
+    HistogramObject* histogram = PyObject_New(HistogramObject, &HistogramType);
+    if (!histogram) {
+        return nullptr;
+    }
+    histogram->state = new (std::nothrow) HistogramState;
+    if (!histogram->state) {
+        Py_DECREF(histogram);
+        return PyErr_NoMemory();
+    }
+    histogram->state->counts = counts;
+    return reinterpret_cast<PyObject*>(histogram);
+}
+
+// Histogram
+
+PyObject* histogram_new(PyTypeObject* type, PyObject* args, PyObject* kwargs)
+{
+    HistogramObject* self = reinterpret_cast<HistogramObject*>(type->tp_alloc(type, 0));
+    if (!self) {
+        return nullptr;
+    }
+    self->state = new (std::nothrow) HistogramState;
+    if (!self->state) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return reinterpret_cast<PyObject*>(self);
+}
+
+void histogram_dealloc(HistogramObject* self)
+{
+    delete self->state;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+PyObject* histogram_update(HistogramObject* self, PyObject* buffer)
+{
+    BufferView view;
+    if (!view.acquire(buffer)) {
+        return nullptr;
+    }
+    // count into the local histogram, so that the lock is held only to add it
+    byte_histogram counts{};
+    bool exported = false;
+    Py_BEGIN_ALLOW_THREADS
+    count_bytes(view.data(), view.size(), counts);
+    {
+        // released before taking the GIL back, so that GIL holders waiting for the lock do not deadlock
+        std::lock_guard<std::mutex> lock(self->state->mutex);
+        exported = self->state->exports > 0;
+        if (!exported) {
+            merge_histograms(self->state->counts, counts);
+        }
+    }
+    Py_END_ALLOW_THREADS
+    if (exported) {
+        PyErr_SetString(PyExc_BufferError, HISTOGRAM_EXPORTED_ERROR);
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+int histogram_init(HistogramObject* self, PyObject* args, PyObject* kwargs)
+{
+    static const char* keywords[] = { "buffer", nullptr };
+    PyObject* buffer = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O", const_cast<char**>(keywords), &buffer)) {
+        return -1;
+    }
+    if (buffer && buffer != Py_None) {
+        PyObject* result = histogram_update(self, buffer);
+        if (!result) {
+            return -1;
+        }
+        Py_DECREF(result);
+    }
+    return 0;
+}
+
+PyObject* histogram_merge(HistogramObject* self, PyObject* other)
+{
+    if (!PyObject_TypeCheck(other, &HistogramType)) {
+        PyErr_SetString(PyExc_TypeError, "Histogram expected");
+        return nullptr;
+    }
+    byte_histogram other_counts;
+    {
+        std::lock_guard<std::mutex> lock(reinterpret_cast<HistogramObject*>(other)->state->mutex);
+        other_counts = reinterpret_cast<HistogramObject*>(other)->state->counts;
+    }
+    std::lock_guard<std::mutex> lock(self->state->mutex);
+    if (self->state->exports > 0) {
+        PyErr_SetString(PyExc_BufferError, HISTOGRAM_EXPORTED_ERROR);
+        return nullptr;
+    }
+    merge_histograms(self->state->counts, other_counts);
+    Py_RETURN_NONE;
+}
+
+PyObject* histogram_entropy_method(HistogramObject* self, PyObject*)
+{
+    std::lock_guard<std::mutex> lock(self->state->mutex);
+    return PyFloat_FromDouble(histogram_entropy(self->state->counts));
+}
+
+PyObject* histogram_counts(HistogramObject* self, PyObject*)
+{
+    byte_histogram counts;
+    {
+        std::lock_guard<std::mutex> lock(self->state->mutex);
+        counts = self->state->counts;
+    }
+    PyObject* list = PyList_New(counts.size());
+    if (!list) {
+        return nullptr;
+    }
+    for (size_t i = 0; i != counts.size(); ++i) {
+        PyObject* count = PyLong_FromUnsignedLongLong(counts[i]);
+        if (!count) {
+            Py_DECREF(list);
+            return nullptr;
+        }
+        PyList_SET_ITEM(list, i, count);
+    }
+    return list;
+}
+
+PyObject* histogram_total_getter(HistogramObject* self, void*)
+{
+    std::lock_guard<std::mutex> lock(self->state->mutex);
+    return PyLong_FromUnsignedLongLong(histogram_total(self->state->counts));
+}
+
+Py_ssize_t histogram_length(HistogramObject*)
+{
+    return 256;
+}
+
+PyObject* histogram_item(HistogramObject* self, Py_ssize_t index)
+{
+    if (index < 0 || index >= 256) {
+        PyErr_SetString(PyExc_IndexError, "byte value out of range");
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(self->state->mutex);
+    return PyLong_FromUnsignedLongLong(self->state->counts[static_cast<size_t>(index)]);
+}
+
+int histogram_getbuffer(HistogramObject* self, Py_buffer* view, int flags)
+{
+    static Py_ssize_t shape = 256;
+    static Py_ssize_t stride = sizeof(uintmax_t);
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "Histogram buffer is read-only");
+        return -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(self->state->mutex);
+        ++self->state->exports;
+    }
+    view->buf = self->state->counts.data();
+    view->obj = reinterpret_cast<PyObject*>(self);
+    Py_INCREF(self);
+    view->len = sizeof(self->state->counts);
+    view->readonly = 1;
+    view->itemsize = sizeof(uintmax_t);
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>("Q") : nullptr;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &shape : nullptr;
+    view->strides = (flags & PyBUF_STRIDES) ? &stride : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    return 0;
+}
+
+void histogram_releasebuffer(HistogramObject* self, Py_buffer*)
+{
+    std::lock_guard<std::mutex> lock(self->state->mutex);
+    --self->state->exports;
+}
+
+PyMethodDef histogram_methods[] = {
+    { "update", reinterpret_cast<PyCFunction>(histogram_update), METH_O,
+        "update(buffer)\n--\n\nCount bytes of the buffer-protocol object, without the GIL\n"
+        "Raises BufferError while the histogram buffer is exported" },
+    { "merge", reinterpret_cast<PyCFunction>(histogram_merge), METH_O,
+        "merge(other)\n--\n\nAdd counts of the other histogram\n"
+        "Raises BufferError while the histogram buffer is exported" },
+    { "entropy", reinterpret_cast<PyCFunction>(histogram_entropy_method), METH_NOARGS,
+        "entropy()\n--\n\nShannon entropy of counted bytes, 0.0 to 8.0" },
+    { "counts", reinterpret_cast<PyCFunction>(histogram_counts), METH_NOARGS,
+        "counts()\n--\n\nList of 256 byte counts" },
+    { nullptr }
+};
+
+PyGetSetDef histogram_getset[] = {
+    { "total", reinterpret_cast<getter>(histogram_total_getter), nullptr, "Number of counted bytes", nullptr },
+    { nullptr }
+};
+
+PySequenceMethods histogram_sequence = {
+    reinterpret_cast<lenfunc>(histogram_length),
+    nullptr,
+    nullptr,
+    reinterpret_cast<ssizeargfunc>(histogram_item),
+};
+
+PyBufferProcs histogram_buffer = {
+    reinterpret_cast<getbufferproc>(histogram_getbuffer),
+    reinterpret_cast<releasebufferproc>(histogram_releasebuffer)
+};
+
+// Stream
+
+PyObject* stream_new(PyTypeObject* type, PyObject* args, PyObject* kwargs)
+{
+    StreamObject* self = reinterpret_cast<StreamObject*>(type->tp_alloc(type, 0));
+    if (!self) {
+        return nullptr;
+    }
+    self->state = new (std::nothrow) StreamState;
+    if (!self->state) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return reinterpret_cast<PyObject*>(self);
+}
+
+void stream_dealloc(StreamObject* self)
+{
+    delete self->state;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+int stream_init(StreamObject* self, PyObject* args, PyObject* kwargs)
+{
+    static const char* keywords[] = { "randomness_tests", nullptr };
+    int randomness_tests = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|p", const_cast<char**>(keywords), &randomness_tests)) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(self->state->mutex);
+    self->state->counts = byte_histogram{};
+    self->state->accumulators = randomness_tests ? AccumulatorSet::randomness_battery() : AccumulatorSet();
+    return 0;
+}
+
+PyObject* stream_update(StreamObject* self, PyObject* buffer)
+{
+    BufferView view;
+    if (!view.acquire(buffer)) {
+        return nullptr;
+    }
+    // accumulators depend on the order of blocks, the whole update is serialized
+    Py_BEGIN_ALLOW_THREADS
+    {
+        std::lock_guard<std::mutex> lock(self->state->mutex);
+        count_bytes(view.data(), view.size(), self->state->counts);
+        if (!self->state->accumulators.empty()) {
+            self->state->accumulators.update(view.data(), view.size());
+        }
+    }
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+PyObject* stream_entropy(StreamObject* self, PyObject*)
+{
+    std::lock_guard<std::mutex> lock(self->state->mutex);
+    return PyFloat_FromDouble(histogram_entropy(self->state->counts));
+}
+
+PyObject* stream_histogram(StreamObject* self, PyObject*)
+{
+    byte_histogram counts;
+    {
+        std::lock_guard<std::mutex> lock(self->state->mutex);
+        counts = self->state->counts;
+    }
+    return new_histogram(counts);
+}
+
+PyObject* stream_report(StreamObject* self, PyObject*)
+{
+    accumulator_results results;
+    {
+        std::lock_guard<std::mutex> lock(self->state->mutex);
+        results = self->state->accumulators.report(self->state->counts);
+    }
+    return results_dict(results);
+}
+
+PyObject* stream_total_getter(StreamObject* self, void*)
+{
+    std::lock_guard<std::mutex> lock(self->state->mutex);
+    return PyLong_FromUnsignedLongLong(histogram_total(self->state->counts));
+}
+
+PyMethodDef stream_methods[] = {
+    { "update", reinterpret_cast<PyCFunction>(stream_update), METH_O,
+        "update(buffer)\n--\n\nFeed the next block of the stream, without the GIL" },
+    { "entropy", reinterpret_cast<PyCFunction>(stream_entropy), METH_NOARGS,
+        "entropy()\n--\n\nShannon entropy of the stream so far" },
+    { "histogram", reinterpret_cast<PyCFunction>(stream_histogram), METH_NOARGS,
+        "histogram()\n--\n\nCopy of the stream histogram" },
+    { "report", reinterpret_cast<PyCFunction>(stream_report), METH_NOARGS,
+        "report()\n--\n\nRandomness tests results as dict, empty without randomness_tests" },
+    { nullptr }
+};
+
+PyGetSetDef stream_getset[] = {
+    { "total", reinterpret_cast<getter>(stream_total_getter), nullptr, "Number of bytes fed", nullptr },
+    { nullptr }
+};
+
+// Module functions
+
+PyObject* count_bytes_function(PyObject*, PyObject* buffer)
+{
+    BufferView view;
+    if (!view.acquire(buffer)) {
+        return nullptr;
+    }
+    byte_histogram counts{};
+    Py_BEGIN_ALLOW_THREADS
+    count_bytes(view.data(), view.size(), counts);
+    Py_END_ALLOW_THREADS
+    return new_histogram(counts);
+}
+
+PyObject* shannon_entropy_function(PyObject*, PyObject* buffer)
+{
+    BufferView view;
+    if (!view.acquire(buffer)) {
+        return nullptr;
+    }
+    double entropy{};
+    Py_BEGIN_ALLOW_THREADS
+    byte_histogram counts{};
+    count_bytes(view.data(), view.size(), counts);
+    entropy = histogram_entropy(counts);
+    Py_END_ALLOW_THREADS
+    return PyFloat_FromDouble(entropy);
+}
+
+PyObject* estimation_function(PyObject*, PyObject* args)
+{
+    double entropy{};
+    unsigned long long size{};
+    if (!PyArg_ParseTuple(args, "dK", &entropy, &size)) {
+        return nullptr;
+    }
+    ShannonEncryptionChecker& checker = get_checker();
+    std::string description = checker.get_information_description(
+        checker.information_entropy_estimation(entropy, static_cast<size_t>(size)));
+    return PyUnicode_FromString(description.c_str());
+}
+
+PyObject* file_entropy_function(PyObject*, PyObject* args, PyObject* kwargs)
+{
+    static const char* keywords[] = { "path", "randomness_tests", nullptr };
+    PyObject* path_object = nullptr;
+    int randomness_tests = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&|p", const_cast<char**>(keywords),
+        PyUnicode_FSConverter, &path_object, &randomness_tests)) {
+        return nullptr;
+    }
+    std::string path = PyBytes_AS_STRING(path_object);
+    Py_DECREF(path_object);
+
+    ShannonEncryptionChecker& checker = get_checker();
+    AccumulatorSet accumulators = randomness_tests ? AccumulatorSet::randomness_battery() : AccumulatorSet();
+    byte_histogram counts{};
+    double entropy{};
+    std::string error;
+
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        entropy = checker.get_file_entropy(path, accumulators, counts);
+    }
+    catch (const std::exception& e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_OSError, error.c_str());
+        return nullptr;
+    }
+
+    uintmax_t size = histogram_total(counts);
+    std::string description = checker.get_information_description(
+        checker.information_entropy_estimation(entropy, static_cast<size_t>(size)));
+
+    PyObject* result = results_dict(accumulators.report(counts));
+    if (!result) {
+        return nullptr;
+    }
+    PyObject* histogram = new_histogram(counts);
+    PyObject* fields[] = {
+        PyLong_FromUnsignedLongLong(size),
+        PyFloat_FromDouble(entropy),
+        PyUnicode_FromString(description.c_str()),
+        PyLong_FromSize_t(checker.min_compressed_size(entropy, static_cast<size_t>(size))),
+        histogram
+    };
+    const char* names[] = { "size", "entropy", "estimation", "min_compressed_size", "histogram" };
+    bool failed = false;
+    for (size_t i = 0; i != sizeof(fields) / sizeof(fields[0]); ++i) {
+        failed = failed || !fields[i] || PyDict_SetItemString(result, names[i], fields[i]) < 0;
+        Py_XDECREF(fields[i]);
+    }
+    if (failed) {
+        Py_DECREF(result);
+        return nullptr;
+    }
+    return result;
+}
+
+PyMethodDef module_methods[] = {
+    { "count_bytes", count_bytes_function, METH_O,
+        "count_bytes(buffer)\n--\n\nHistogram of the buffer-protocol object" },
+    { "shannon_entropy", shannon_entropy_function, METH_O,
+        "shannon_entropy(buffer)\n--\n\nShannon entropy of the buffer-protocol object, 0.0 to 8.0" },
+    { "estimation", estimation_function, METH_VARARGS,
+        "estimation(entropy, size)\n--\n\nInformation entropy estimation: Plain, Binary or Encrypted" },
+    { "file_entropy", reinterpret_cast<PyCFunction>(file_entropy_function), METH_VARARGS | METH_KEYWORDS,
+        "file_entropy(path, randomness_tests=False)\n--\n\n"
+        "Scan the file without the GIL, return dict with size, entropy, estimation, "
+        "min_compressed_size, histogram and randomness tests" },
+    { nullptr }
+};
+
+PyModuleDef entropy_module = {
+    PyModuleDef_HEAD_INIT,
+    "entropy",
+    "Shannon entropy of byte sequences, zero-copy over buffer-protocol objects",
+    -1,
+    module_methods
+};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit_entropy()
+{
+    HistogramType.tp_name = "entropy.Histogram";
+    HistogramType.tp_doc = "Histogram(buffer=None)\n--\n\nCounts of every byte value, mergeable";
+    HistogramType.tp_basicsize = sizeof(HistogramObject);
+    HistogramType.tp_flags = Py_TPFLAGS_DEFAULT;
+    HistogramType.tp_new = histogram_new;
+    HistogramType.tp_init = reinterpret_cast<initproc>(histogram_init);
+    HistogramType.tp_dealloc = reinterpret_cast<destructor>(histogram_dealloc);
+    HistogramType.tp_methods = histogram_methods;
+    HistogramType.tp_getset = histogram_getset;
+    HistogramType.tp_as_sequence = &histogram_sequence;
+    HistogramType.tp_as_buffer = &histogram_buffer;
+
+    StreamType.tp_name = "entropy.Stream";
+    StreamType.tp_doc = "Stream(randomness_tests=False)\n--\n\nHistogram and randomness tests of the stream fed block by block";
+    StreamType.tp_basicsize = sizeof(StreamObject);
+    StreamType.tp_flags = Py_TPFLAGS_DEFAULT;
+    StreamType.tp_new = stream_new;
+    StreamType.tp_init = reinterpret_cast<initproc>(stream_init);
+    StreamType.tp_dealloc = reinterpret_cast<destructor>(stream_dealloc);
+    StreamType.tp_methods = stream_methods;
+    StreamType.tp_getset = stream_getset;
+
+    if (PyType_Ready(&HistogramType) < 0 || PyType_Ready(&StreamType) < 0) {
+        return nullptr;
+    }
+
+    PyObject* module = PyModule_Create(&entropy_module);
+    if (!module) {
+        return nullptr;
+    }
+    Py_INCREF(&HistogramType);
+    Py_INCREF(&StreamType);
+    if (PyModule_AddObject(module, "Histogram", reinterpret_cast<PyObject*>(&HistogramType)) < 0
+        || PyModule_AddObject(module, "Stream", reinterpret_cast<PyObject*>(&StreamType)) < 0) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+
+    get_checker();
+    return module;
+}
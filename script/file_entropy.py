@@ -9,25 +9,21 @@
 # (Assuming the file is a string of byte-size (UTF-8?) characters
 # because if not then the Shannon Entropy value would be different.)
 # FB - 201011291
+#
+# Counting is done by the native `entropy` module built from the python/ directory,
+# add its build directory to PYTHONPATH, e.g. PYTHONPATH=build/python
 import os
 import sys
-import math
-import itertools
-import struct
 
+try:
+    import entropy
+except ImportError:
+    print("Native module 'entropy' is not found: build the project with CMake "
+          "and add <build>/python directory to PYTHONPATH")
+    sys.exit(1)
 
-def shannon_entropy(frequency_array):
-    """
-    :param frequency_array: list of 255 elements, every of each is a frequency
-    of a byte with that number has been met in a measured sample. For example,
-    frequency_array[0] = 0.5 means 50% of bytes in the file are 0x00
-    :return: entropy from 0.0 to 8.0, where 0.0 is order, 8.0 is chaos
-    """
-    ent = 0.0
-    for freq in frequency_array:
-        if freq > 0:
-            ent = ent + freq * math.log(freq, 2)
-    return -ent
+# File is read by blocks of this size into the same buffer
+BLOCK_SIZE = 1024 * 1024
 
 
 # For printing iterations progress
@@ -74,39 +70,51 @@ class ProgressBar:
             print()
 
 
+def file_stream(file_name, file_size, randomness_tests):
+    """
+    Feed the file to the native stream block by block
+    :param randomness_tests: also calculate chi-square, mean, Monte Carlo Pi and serial correlation
+    :return: entropy.Stream with the whole file counted
+    """
+    stream = entropy.Stream(randomness_tests=randomness_tests)
+    progress_bar = ProgressBar(file_size, prefix='Progress:', suffix='Complete', length=50) if file_size else None
+
+    # readinto() reuses the buffer, memoryview passes it to the module without copying
+    buffer = bytearray(BLOCK_SIZE)
+    view = memoryview(buffer)
+    counter = 0
+    with open(file_name, "rb") as f:
+        while True:
+            read_size = f.readinto(buffer)
+            if not read_size:
+                break
+            stream.update(view[:read_size])
+            counter += read_size
+            if progress_bar:
+                progress_bar.iterate(counter)
+    return stream
+
+
 # Shannon entropy
 if __name__ == '__main__':
 
-    if len(sys.argv) != 2:
-        print("Usage: file_entropy.py [path filename]")
+    arguments = [arg for arg in sys.argv[1:] if arg != '--randomness-tests']
+    if len(arguments) != 1:
+        print("Usage: file_entropy.py [--randomness-tests] [path filename]")
         sys.exit()
 
-    file_name = sys.argv[1]
+    file_name = arguments[0]
 
     file_size = os.stat(file_name).st_size
     print('File size in bytes: {0}'.format(file_size))
 
-    progress_bar = ProgressBar(file_size, prefix='Progress:', suffix='Complete', length=50)
-
-    bytes_list = list(itertools.repeat(0, 256))
-    with open(file_name, "rb") as f:
-        read_byte = f.read(1)
-        counter = 0
-        percent_counter = 0
-        while read_byte != b"":
-            # Do stuff with byte
-            value = struct.unpack('B', read_byte)[0]
-            bytes_list[value] += 1
-            counter += 1
-            # Check if percentage changed not to re-print on every iteration, print() is heavy operation
-            progress_bar.iterate(counter)
-            read_byte = f.read(1)
-
-    # divide by file size
-    frequency_list = [float(elem)/file_size for elem in bytes_list]
+    stream = file_stream(file_name, file_size, '--randomness-tests' in sys.argv)
+    file_entropy = stream.entropy()
 
-    entropy = shannon_entropy(frequency_list)
-    print('Shannon entropy (min bits per byte-character): {0}'.format(entropy))
+    print('Shannon entropy (min bits per byte-character): {0}'.format(file_entropy))
+    print('Information entropy estimation: {0}'.format(entropy.estimation(file_entropy, stream.total)))
     print('Min possible file size assuming max theoretical compression efficiency:')
-    print('{0} in bits'.format(entropy * file_size))
-    print('{0} in bytes'.format((entropy * file_size) / 8))
+    print('{0} in bits'.format(file_entropy * stream.total))
+    print('{0} in bytes'.format((file_entropy * stream.total) / 8))
+    for name, value in stream.report().items():
+        print('{0} = {1}'.format(name, value))
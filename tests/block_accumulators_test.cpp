@@ -0,0 +1,114 @@
+#define BOOST_TEST_MODULE entropy
+#include <boost/test/unit_test.hpp>
+
+#include <entropy/block_accumulators.h>
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <vector>
+
+// Ranges counted separately and merged in order must give exactly the single pass result,
+// so that the stream could be split between threads or resumed from the saved state
+
+using namespace entropy;
+
+namespace {
+
+std::vector<uint8_t> random_bytes(size_t size, uint32_t seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t& value : bytes) {
+        value = static_cast<uint8_t>(byte(generator));
+    }
+    return bytes;
+}
+
+/// Feed the range by blocks of random size, as file reads end at arbitrary offsets
+void update_by_blocks(AccumulatorSet& accumulators, const uint8_t* data, size_t size, std::mt19937& generator)
+{
+    std::uniform_int_distribution<size_t> block_size(1, 4096);
+    for (size_t offset = 0; offset < size; ) {
+        size_t block = std::min(block_size(generator), size - offset);
+        accumulators.update(data + offset, block);
+        offset += block;
+    }
+}
+
+accumulator_results single_pass(const std::vector<uint8_t>& bytes)
+{
+    AccumulatorSet accumulators = AccumulatorSet::randomness_battery();
+    accumulators.update(bytes.data(), bytes.size());
+    byte_histogram counts{};
+    count_bytes(bytes.data(), bytes.size(), counts);
+    return accumulators.report(counts);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(merged_ranges_equal_single_pass)
+{
+    const std::vector<uint8_t> bytes = random_bytes(100003, 1);
+    const accumulator_results expected = single_pass(bytes);
+
+    byte_histogram counts{};
+    count_bytes(bytes.data(), bytes.size(), counts);
+
+    std::mt19937 generator(2);
+    std::uniform_int_distribution<size_t> ranges_count(1, 16);
+    std::uniform_int_distribution<size_t> split(0, bytes.size());
+
+    for (int attempt = 0; attempt != 500; ++attempt) {
+
+        // random split points, empty ranges and ranges shorter than a Monte Carlo group included
+        std::vector<size_t> bounds{ 0, bytes.size() };
+        for (size_t i = ranges_count(generator); i != 0; --i) {
+            size_t point = split(generator);
+            bounds.push_back(point);
+            bounds.push_back(std::min(point + generator() % 8, bytes.size()));
+        }
+        std::sort(bounds.begin(), bounds.end());
+
+        AccumulatorSet merged = AccumulatorSet::randomness_battery();
+        for (size_t i = 0; i + 1 != bounds.size(); ++i) {
+            AccumulatorSet range = merged.clone_empty(bounds[i]);
+            update_by_blocks(range, bytes.data() + bounds[i], bounds[i + 1] - bounds[i], generator);
+            merged.merge(range);
+        }
+
+        // bit-identical, not approximately equal
+        BOOST_TEST_REQUIRE((merged.report(counts) == expected), "split attempt " << attempt);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(saved_state_resumes_single_pass)
+{
+    const std::vector<uint8_t> bytes = random_bytes(50001, 3);
+    const accumulator_results expected = single_pass(bytes);
+
+    byte_histogram counts{};
+    count_bytes(bytes.data(), bytes.size(), counts);
+
+    for (size_t offset : { size_t(0), size_t(1), size_t(5), size_t(6), size_t(12345), bytes.size() }) {
+        AccumulatorSet first = AccumulatorSet::randomness_battery();
+        first.update(bytes.data(), offset);
+        std::stringstream state;
+        first.save(state);
+
+        AccumulatorSet resumed = AccumulatorSet::randomness_battery();
+        BOOST_TEST_REQUIRE(resumed.load(state));
+        resumed.update(bytes.data() + offset, bytes.size() - offset);
+        BOOST_TEST((resumed.report(counts) == expected), "resumed at " << offset);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(state_of_other_set_is_rejected)
+{
+    AccumulatorSet battery = AccumulatorSet::randomness_battery();
+    std::stringstream state;
+    battery.save(state);
+
+    AccumulatorSet empty;
+    BOOST_TEST(!empty.load(state));
+}
@@ -0,0 +1,203 @@
+#include <boost/test/unit_test.hpp>
+
+#include <entropy/scan_checkpoint.h>
+#include <entropy/shannon_entropy.h>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+// Checkpoint and incremental state round trip, and the file pass continued from them
+// gives exactly the result of the pass from the start
+
+using namespace entropy;
+namespace fs = boost::filesystem;
+
+namespace {
+
+/// Temporary directory removed with all sidecar files
+struct TemporaryDirectory {
+    fs::path path = fs::temp_directory_path() / fs::unique_path("entropy-test-%%%%-%%%%-%%%%");
+
+    TemporaryDirectory() {
+        fs::create_directories(path);
+    }
+    ~TemporaryDirectory() {
+        boost::system::error_code error;
+        fs::remove_all(path, error);
+    }
+};
+
+std::vector<uint8_t> random_bytes(size_t size, uint32_t seed)
+{
+    std::mt19937 generator(seed);
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t& value : bytes) {
+        value = static_cast<uint8_t>(generator() % 251);
+    }
+    return bytes;
+}
+
+void append_file(const fs::path& path, const std::vector<uint8_t>& bytes, size_t offset, size_t size)
+{
+    std::ofstream file(path.string(), std::ios::out | std::ios::binary | std::ios::app);
+    file.write(reinterpret_cast<const char*>(bytes.data() + offset), static_cast<std::streamsize>(size));
+}
+
+struct ScanResult {
+    double entropy{};
+    byte_histogram counts{};
+    accumulator_results tests;
+    uintmax_t restored_bytes{};
+};
+
+ScanResult scan_file(const ShannonEncryptionChecker& shannon, const fs::path& path)
+{
+    ScanResult result;
+    AccumulatorSet accumulators = AccumulatorSet::randomness_battery();
+    result.entropy = shannon.get_file_entropy(path.string(), accumulators, result.counts, &result.restored_bytes);
+    result.tests = accumulators.report(result.counts);
+    return result;
+}
+
+void check_same_result(const ScanResult& result, const ScanResult& expected)
+{
+    BOOST_TEST(result.entropy == expected.entropy);
+    BOOST_TEST((result.counts == expected.counts));
+    BOOST_TEST((result.tests == expected.tests));
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(checkpoint_round_trip)
+{
+    TemporaryDirectory directory;
+    std::string checkpoint_path = (directory.path / "checkpoint").string();
+
+    ScanCheckpoint checkpoint;
+    checkpoint.file_size = 123456789;
+    checkpoint.last_write_time = 1600000000;
+    checkpoint.offset = 65536;
+    checkpoint.counts[0] = 65000;
+    checkpoint.counts[255] = 536;
+    checkpoint.accumulators_state = std::string("state\0with\0zeros", 16);
+    checkpoint.save(checkpoint_path);
+
+    ScanCheckpoint loaded;
+    BOOST_TEST_REQUIRE(loaded.load(checkpoint_path));
+    BOOST_TEST(loaded.file_size == checkpoint.file_size);
+    BOOST_TEST(loaded.last_write_time == checkpoint.last_write_time);
+    BOOST_TEST(loaded.offset == checkpoint.offset);
+    BOOST_TEST((loaded.counts == checkpoint.counts));
+    BOOST_TEST(loaded.accumulators_state == checkpoint.accumulators_state);
+
+    // damaged byte is detected by the checksum
+    {
+        std::fstream file(checkpoint_path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(20);
+        file.put('\x7f');
+    }
+    BOOST_TEST(!loaded.load(checkpoint_path));
+    BOOST_TEST(!loaded.load((directory.path / "missing").string()));
+}
+
+BOOST_AUTO_TEST_CASE(incremental_state_round_trip)
+{
+    TemporaryDirectory directory;
+    std::string state_path = (directory.path / "state").string();
+
+    IncrementalState state;
+    state.file_size = 1000;
+    state.tail_size = 1000;
+    state.tail_hash = 42;
+    state.counts[7] = 1000;
+    state.accumulators_state = "accumulators";
+    state.save(state_path);
+
+    IncrementalState loaded;
+    BOOST_TEST_REQUIRE(loaded.load(state_path));
+    BOOST_TEST(loaded.file_size == state.file_size);
+    BOOST_TEST(loaded.tail_size == state.tail_size);
+    BOOST_TEST(loaded.tail_hash == state.tail_hash);
+    BOOST_TEST((loaded.counts == state.counts));
+    BOOST_TEST(loaded.accumulators_state == state.accumulators_state);
+
+    // checksum is not a signature: state with the tail bigger than the read buffer is rejected by bounds
+    state.file_size = 1000000;
+    state.tail_size = 1000000;
+    state.counts[7] = 1000000;
+    state.save(state_path);
+    BOOST_TEST(!loaded.load(state_path));
+}
+
+BOOST_AUTO_TEST_CASE(resumed_scan_equals_full_scan)
+{
+    TemporaryDirectory directory;
+    fs::path file_path = directory.path / "data";
+    const std::vector<uint8_t> bytes = random_bytes(3 * 1024 * 1024 + 7, 1);
+    append_file(file_path, bytes, 0, bytes.size());
+
+    ShannonEncryptionChecker shannon;
+    const ScanResult expected = scan_file(shannon, file_path);
+
+    // state of the pass interrupted at an offset which is not a multiple of the block size
+    const size_t offset = 1024 * 1024 + 3;
+    ScanCheckpoint checkpoint;
+    checkpoint.file_size = fs::file_size(file_path);
+    checkpoint.last_write_time = static_cast<int64_t>(fs::last_write_time(file_path));
+    checkpoint.offset = offset;
+    count_bytes(bytes.data(), offset, checkpoint.counts);
+    AccumulatorSet accumulators = AccumulatorSet::randomness_battery();
+    accumulators.update(bytes.data(), offset);
+    std::ostringstream state;
+    accumulators.save(state);
+    checkpoint.accumulators_state = state.str();
+    checkpoint.save(ScanCheckpoint::sidecar_path(file_path.string()));
+
+    ShannonEncryptionChecker resuming;
+    resuming.set_checkpoint(1024 * 1024, true);
+    ScanResult resumed = scan_file(resuming, file_path);
+    BOOST_TEST(resumed.restored_bytes == offset);
+    check_same_result(resumed, expected);
+
+    // completed pass removes the checkpoint
+    BOOST_TEST(!fs::exists(ScanCheckpoint::sidecar_path(file_path.string())));
+}
+
+BOOST_AUTO_TEST_CASE(incremental_rescan_equals_full_scan)
+{
+    TemporaryDirectory directory;
+    fs::path file_path = directory.path / "log";
+    const std::vector<uint8_t> bytes = random_bytes(2 * 1024 * 1024 + 11, 2);
+    const size_t first_size = 1024 * 1024 + 5;
+
+    ShannonEncryptionChecker incremental;
+    incremental.set_incremental(true);
+
+    append_file(file_path, bytes, 0, first_size);
+    BOOST_TEST(scan_file(incremental, file_path).restored_bytes == 0);
+
+    append_file(file_path, bytes, first_size, bytes.size() - first_size);
+    ScanResult rescanned = scan_file(incremental, file_path);
+    BOOST_TEST(rescanned.restored_bytes == first_size);
+
+    ShannonEncryptionChecker shannon;
+    check_same_result(rescanned, scan_file(shannon, file_path));
+
+    // rewritten file does not match the stored tail and is counted from the start
+    fs::remove(file_path);
+    std::vector<uint8_t> rewritten = random_bytes(bytes.size() + 100, 3);
+    append_file(file_path, rewritten, 0, rewritten.size());
+    BOOST_TEST(scan_file(incremental, file_path).restored_bytes == 0);
+}
+
+BOOST_AUTO_TEST_CASE(sidecar_files_are_recognised)
+{
+    BOOST_TEST(is_scan_sidecar(ScanCheckpoint::sidecar_path("dir/data.bin")));
+    BOOST_TEST(is_scan_sidecar(IncrementalState::sidecar_path("dir/app.log")));
+    BOOST_TEST(is_scan_sidecar(ScanCheckpoint::sidecar_path("dir/data.bin") + ".tmp"));
+    BOOST_TEST(!is_scan_sidecar("dir/data.bin"));
+    BOOST_TEST(!is_scan_sidecar("dir/archive.tmp"));
+    BOOST_TEST(!is_scan_sidecar("dir/app.entropy-state.log"));
+}